@@ -0,0 +1,67 @@
+#include "scratch.hpp"
+
+#include <algorithm>
+
+#include <cuda_runtime.h>
+
+CuScratch::~CuScratch() {
+    for (const auto &overflow : overflows_) {
+        cudaFree(overflow.ptr);
+    }
+    cudaFree(buffer_);
+}
+
+void CuScratch::Reserve(size_t size) {
+    size = PieceSize(size);
+    if (size <= capacity_ || offset_ != 0 || !overflows_.empty()) {
+        return;
+    }
+    cudaFree(buffer_);
+    cudaMalloc(&buffer_, size);
+    capacity_ = size;
+    peak_ = std::max(peak_, size);
+}
+
+void *CuScratch::Allocate(size_t size) {
+    size = PieceSize(size);
+    void *ptr = buffer_ + offset_;
+    if (offset_ + size <= capacity_) {
+        offset_ += size;
+    } else {
+        cudaMalloc(&ptr, size);
+        overflows_.push_back({ ptr, size });
+        overflow_size_ += size;
+    }
+    peak_ = std::max(peak_, offset_ + overflow_size_);
+    return ptr;
+}
+
+void CuScratch::deallocate(char *ptr, size_t size) {
+    size = PieceSize(size);
+    if (!overflows_.empty() && overflows_.back().ptr == ptr) {
+        cudaFree(ptr);
+        overflow_size_ -= overflows_.back().size;
+        overflows_.pop_back();
+    } else if (reinterpret_cast<uint8_t *>(ptr) + size == buffer_ + offset_) {
+        offset_ -= size;
+    }
+}
+
+void CuScratch::Release(size_t offset, size_t num_overflows) {
+    while (overflows_.size() > num_overflows) {
+        cudaFree(overflows_.back().ptr);
+        overflow_size_ -= overflows_.back().size;
+        overflows_.pop_back();
+    }
+    offset_ = std::min(offset_, offset);
+    if (offset_ == 0 && overflows_.empty() && peak_ > capacity_) {
+        Reserve(peak_);
+    }
+}
+
+CuScratch::Scope::Scope(CuScratch &scratch)
+    : scratch_(scratch), offset_(scratch.offset_), num_overflows_(scratch.overflows_.size()) {}
+
+CuScratch::Scope::~Scope() {
+    scratch_.Release(offset_, num_overflows_);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// device memory kept across uses for temporary buffers, handed out in stack order and taken back when the
+// `Scope` they are allocated in ends, pieces that do not fit are allocated on their own and the memory grows to
+// the peak use once nothing is allocated, so that repeated uses of the same size allocate nothing
+class CuScratch {
+public:
+    // pieces start at multiples of this, the size of a piece is rounded up to it
+    static constexpr size_t kAlignment = 256;
+
+    CuScratch() = default;
+    ~CuScratch();
+
+    CuScratch(const CuScratch &rhs) = delete;
+    CuScratch &operator=(const CuScratch &rhs) = delete;
+
+    // bytes `size` bytes of pieces take
+    static size_t PieceSize(size_t size) { return (size + kAlignment - 1) / kAlignment * kAlignment; }
+
+    // grows the memory to at least `size` bytes, does nothing while some piece is allocated
+    void Reserve(size_t size);
+    size_t Capacity() const { return capacity_; }
+    // most bytes allocated at once so far
+    size_t Peak() const { return peak_; }
+
+    void *Allocate(size_t size);
+    template <typename T>
+    T *Allocate(size_t count) { return reinterpret_cast<T *>(Allocate(sizeof(T) * count)); }
+
+    // allocator of temporary storage for thrust algorithms run with `thrust::cuda::par(scratch)`,
+    // a piece freed out of stack order is taken back with its scope instead
+    using value_type = char;
+    char *allocate(std::ptrdiff_t size) { return reinterpret_cast<char *>(Allocate(size)); }
+    void deallocate(char *ptr, size_t size);
+
+    class Scope {
+    public:
+        explicit Scope(CuScratch &scratch);
+        ~Scope();
+
+        Scope(const Scope &rhs) = delete;
+        Scope &operator=(const Scope &rhs) = delete;
+
+    private:
+        CuScratch &scratch_;
+        size_t offset_;
+        size_t num_overflows_;
+    };
+
+private:
+    struct Overflow {
+        void *ptr;
+        size_t size;
+    };
+
+    void Release(size_t offset, size_t num_overflows);
+
+    uint8_t *buffer_ = nullptr;
+    size_t capacity_ = 0;
+    size_t offset_ = 0;
+    std::vector<Overflow> overflows_;
+    size_t overflow_size_ = 0;
+    size_t peak_ = 0;
+};
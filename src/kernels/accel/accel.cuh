@@ -1,176 +1,584 @@
-#pragma once
-
-#include "../geometry/geometry.cuh"
-
-namespace kernel {
-
-struct AccelHitInfo {
-    uint32_t instance_id;
-    uint32_t primitive_id;
-    glm::vec2 attribs;
-    glm::mat4 transform;
-    glm::mat4 transform_inv;
-};
-
-struct Bbox {
-    glm::vec4 pmin;
-    glm::vec4 pmax;
-};
-
-struct AccelNode {
-    uint32_t lc_or_id;
-    uint32_t rc;
-};
-
-namespace {
-
-CU_DEVICE void Swap(float &a, float &b) {
-    float t = a;
-    a = b;
-    b = t;
-}
-
-CU_DEVICE bool BboxIntersect(const glm::vec3 &pmin, const glm::vec3 &pmax, const Ray &ray) {
-    auto x0 = (pmin.x - ray.origin.x) / ray.direction.x;
-    auto x1 = (pmax.x - ray.origin.x) / ray.direction.x;
-    if (x0 > x1) {
-        Swap(x0, x1);
-    }
-    auto y0 = (pmin.y - ray.origin.y) / ray.direction.y;
-    auto y1 = (pmax.y - ray.origin.y) / ray.direction.y;
-    if (y0 > y1) {
-        Swap(y0, y1);
-    }
-    auto z0 = (pmin.z - ray.origin.z) / ray.direction.z;
-    auto z1 = (pmax.z - ray.origin.z) / ray.direction.z;
-    if (z0 > z1) {
-        Swap(z0, z1);
-    }
-    auto t0 = fmax(x0, fmax(y0, z0));
-    auto t1 = fmin(x1, fmin(y1, z1));
-    return t0 <= t1 && t0 < ray.tmax && t1 > ray.tmin;
-}
-
-CU_DEVICE Ray TransformRay(const Ray &ray, const glm::mat4 &trans) {
-    Ray res = ray;
-    res.origin = trans * glm::vec4(res.origin, 1.0f);
-    res.direction = trans * glm::vec4(res.direction, 0.0f);
-    return res;
-}
-
-}
-
-struct AccelBottom {
-    AccelNode *nodes;
-    Bbox *bboxes;
-    Geometry geometry;
-
-    CU_DEVICE bool Intersect(Ray &ray, AccelHitInfo &hit_info) const {
-        uint32_t stack[32];
-        stack[0] = 0;
-        uint32_t sp = 1;
-        bool intersected = false;
-        while (sp > 0) {
-            auto u = stack[--sp];
-            if (BboxIntersect(bboxes[u].pmin, bboxes[u].pmax, ray)) {
-                if (nodes[u].rc == ~0u) {
-                    float t;
-                    if (geometry.Intersect(ray, nodes[u].lc_or_id, t, hit_info.attribs)) {
-                        ray.tmax = t;
-                        hit_info.primitive_id = nodes[u].lc_or_id;
-                        intersected = true;
-                    }
-                } else {
-                    stack[sp++] = nodes[u].lc_or_id;
-                    stack[sp++] = nodes[u].rc;
-                }
-            }
-        }
-        return intersected;
-    }
-
-    CU_DEVICE bool Occlude(const Ray &ray) const {
-        uint32_t stack[32];
-        stack[0] = 0;
-        uint32_t sp = 1;
-        while (sp > 0) {
-            auto u = stack[--sp];
-            if (BboxIntersect(bboxes[u].pmin, bboxes[u].pmax, ray)) {
-                if (nodes[u].rc == ~0u) {
-                    float t;
-                    glm::vec2 attribs;
-                    if (geometry.Intersect(ray, nodes[u].lc_or_id, t, attribs)) {
-                        return true;
-                    }
-                } else {
-                    stack[sp++] = nodes[u].lc_or_id;
-                    stack[sp++] = nodes[u].rc;
-                }
-            }
-        }
-        return false;
-    }
-};
-
-struct AccelTop {
-    AccelNode *nodes;
-    Bbox *bboxes;
-    struct Instance {
-        AccelBottom *accel;
-        glm::mat4 transform;
-        glm::mat4 transform_inv;
-    } *instances;
-
-    CU_DEVICE bool Intersect(Ray &ray, AccelHitInfo &hit_info) const {
-        uint32_t stack[32];
-        stack[0] = 0;
-        uint32_t sp = 1;
-        bool intersected = false;
-        while (sp > 0) {
-            auto u = stack[--sp];
-            if (BboxIntersect(bboxes[u].pmin, bboxes[u].pmax, ray)) {
-                if (nodes[u].rc == ~0u) {
-                    auto inst_id = nodes[u].lc_or_id;
-                    auto &inst = instances[inst_id];
-                    auto local_ray = TransformRay(ray, inst.transform_inv);
-                    if (inst.accel->Intersect(local_ray, hit_info)) {
-                        ray.tmax = local_ray.tmax;
-                        hit_info.instance_id = inst_id;
-                        hit_info.transform = inst.transform;
-                        hit_info.transform_inv = inst.transform_inv;
-                        intersected = true;
-                    }
-                } else {
-                    stack[sp++] = nodes[u].lc_or_id;
-                    stack[sp++] = nodes[u].rc;
-                }
-            }
-        }
-        return intersected;
-    }
-
-    CU_DEVICE bool Occlude(const Ray &ray) const {
-        uint32_t stack[32];
-        stack[0] = 0;
-        uint32_t sp = 1;
-        while (sp > 0) {
-            auto u = stack[--sp];
-            if (BboxIntersect(bboxes[u].pmin, bboxes[u].pmax, ray)) {
-                if (nodes[u].rc == ~0u) {
-                    auto inst_id = nodes[u].lc_or_id;
-                    auto &inst = instances[inst_id];
-                    auto local_ray = TransformRay(ray, inst.transform_inv);
-                    if (inst.accel->Occlude(local_ray)) {
-                        return true;
-                    }
-                } else {
-                    stack[sp++] = nodes[u].lc_or_id;
-                    stack[sp++] = nodes[u].rc;
-                }
-            }
-        }
-        return false;
-    }
-};
-
-}
+#pragma once
+
+#include "../geometry/geometry.cuh"
+
+namespace kernel {
+
+// transforms of the hit instance are fetched from the instance table when shading
+struct AccelHitInfo {
+    uint32_t instance_id;
+    // level of detail of the instance that is hit, 0 for its full mesh
+    uint32_t lod;
+    uint32_t primitive_id;
+    glm::vec2 attribs;
+};
+
+// last primitive that blocked a shadow ray, tested first by the next one as it is likely to block it too,
+// `index` is the position of the primitive in BVH leaf order of the level of detail `lod` of the instance,
+// and the cache is empty if `instance_id` is `kAccelInvalidOccluder`
+struct AccelOccluder {
+    uint32_t instance_id;
+    uint32_t lod;
+    uint32_t index;
+};
+
+constexpr uint32_t kAccelInvalidOccluder = ~0u;
+
+struct Bbox {
+    glm::vec4 pmin;
+    glm::vec4 pmax;
+};
+
+constexpr uint32_t kAccelLeafBit = 0x80000000u;
+constexpr uint32_t kAccelInvalidChild = ~0u;
+
+constexpr uint32_t kAccelMaxLeafSize = 8;
+// children of packed layouts with `kAccelLeafBit` set are leaves,
+// holding the first primitive in the low bits and the number of primitives minus 1 above
+constexpr uint32_t kAccelLeafSizeShift = 28;
+constexpr uint32_t kAccelLeafFirstMask = (1u << kAccelLeafSizeShift) - 1;
+
+// a leaf holds `NumPrimitives()` primitives from `lc_or_id`,
+// which are indices into the primitive ids of the tree if there are any
+struct AccelNode {
+    uint32_t lc_or_id;
+    uint32_t rc;
+
+    CU_DEVICE_HOST bool IsLeaf() const { return rc & kAccelLeafBit; }
+    CU_DEVICE_HOST uint32_t NumPrimitives() const { return rc & ~kAccelLeafBit; }
+};
+
+inline CU_DEVICE_HOST AccelNode AccelLeafNode(uint32_t first, uint32_t num_primitives) {
+    return AccelNode { first, kAccelLeafBit | num_primitives };
+}
+
+inline CU_DEVICE_HOST uint32_t AccelPackedLeaf(uint32_t first, uint32_t num_primitives) {
+    return kAccelLeafBit | ((num_primitives - 1) << kAccelLeafSizeShift) | first;
+}
+
+enum struct AccelLayout {
+    eBinary,
+    eWide4,
+    eWide8,
+    eCompact,
+    // binary nodes traversed without a stack, packed nodes hold the parent of each node
+    eStackless,
+    // 8 wide nodes with child bounds quantized to 8 bits
+    eQuantized,
+};
+
+constexpr uint32_t kAccelMaxWidth = 8;
+
+// children are packed at the front, unused slots are `kAccelInvalidChild`
+template <uint32_t Width>
+struct AccelWideNode {
+    float pmin_x[Width];
+    float pmin_y[Width];
+    float pmin_z[Width];
+    float pmax_x[Width];
+    float pmax_y[Width];
+    float pmax_z[Width];
+    uint32_t children[Width];
+};
+
+// wide node taking 96 bytes instead of 224, child bounds are stored in 8 bits per axis on a grid over the node,
+// `origin + q * scale` where `scale` is the power of 2 with biased exponent `exponents`,
+// rounded outwards so that they contain the exact bounds
+struct AccelQuantizedNode {
+    glm::vec3 origin;
+    uint8_t exponents[3];
+    uint8_t padding;
+    uint8_t qmin_x[kAccelMaxWidth];
+    uint8_t qmin_y[kAccelMaxWidth];
+    uint8_t qmin_z[kAccelMaxWidth];
+    uint8_t qmax_x[kAccelMaxWidth];
+    uint8_t qmax_y[kAccelMaxWidth];
+    uint8_t qmax_z[kAccelMaxWidth];
+    uint32_t children[kAccelMaxWidth];
+
+    // `q * scale` is exact, so decoding gives the same bounds with or without fused multiply-add
+    CU_DEVICE_HOST glm::vec3 Scale() const {
+        return glm::vec3(
+            glm::uintBitsToFloat(static_cast<uint32_t>(exponents[0]) << 23),
+            glm::uintBitsToFloat(static_cast<uint32_t>(exponents[1]) << 23),
+            glm::uintBitsToFloat(static_cast<uint32_t>(exponents[2]) << 23)
+        );
+    }
+};
+
+// binary node holding the bounds of both children, 32 bytes per child
+struct AccelCompactNode {
+    glm::vec3 lc_pmin;
+    uint32_t lc;
+    glm::vec3 lc_pmax;
+    uint32_t rc;
+    glm::vec3 rc_pmin;
+    uint32_t padding0;
+    glm::vec3 rc_pmax;
+    uint32_t padding1;
+};
+
+namespace {
+
+constexpr uint32_t kAccelStackSize = 32;
+// wide trees needing more entries are packed as `AccelLayout::eStackless` instead
+constexpr uint32_t kAccelWideStackSize = 64;
+
+CU_DEVICE void Swap(float &a, float &b) {
+    float t = a;
+    a = b;
+    b = t;
+}
+
+CU_DEVICE bool BboxIntersect(const glm::vec3 &pmin, const glm::vec3 &pmax, const Ray &ray) {
+    auto x0 = (pmin.x - ray.origin.x) / ray.direction.x;
+    auto x1 = (pmax.x - ray.origin.x) / ray.direction.x;
+    if (x0 > x1) {
+        Swap(x0, x1);
+    }
+    auto y0 = (pmin.y - ray.origin.y) / ray.direction.y;
+    auto y1 = (pmax.y - ray.origin.y) / ray.direction.y;
+    if (y0 > y1) {
+        Swap(y0, y1);
+    }
+    auto z0 = (pmin.z - ray.origin.z) / ray.direction.z;
+    auto z1 = (pmax.z - ray.origin.z) / ray.direction.z;
+    if (z0 > z1) {
+        Swap(z0, z1);
+    }
+    auto t0 = fmax(x0, fmax(y0, z0));
+    auto t1 = fmin(x1, fmin(y1, z1));
+    return t0 <= t1 && t0 < ray.tmax && t1 > ray.tmin;
+}
+
+CU_DEVICE bool BboxIntersect(const glm::vec3 &pmin, const glm::vec3 &pmax, const Ray &ray, const glm::vec3 &inv_dir,
+    float &t) {
+    auto t0s = (pmin - ray.origin) * inv_dir;
+    auto t1s = (pmax - ray.origin) * inv_dir;
+    auto tmin = glm::min(t0s, t1s);
+    auto tmax = glm::max(t0s, t1s);
+    auto t0 = fmax(tmin.x, fmax(tmin.y, tmin.z));
+    auto t1 = fmin(tmax.x, fmin(tmax.y, tmax.z));
+    t = t0;
+    return t0 <= t1 && t0 < ray.tmax && t1 > ray.tmin;
+}
+
+CU_DEVICE Ray TransformRay(const Ray &ray, const glm::mat4x3 &trans) {
+    Ray res = ray;
+    res.origin = trans * glm::vec4(res.origin, 1.0f);
+    res.direction = trans * glm::vec4(res.direction, 0.0f);
+    return res;
+}
+
+// `on_leaf(primitive_id)` returns true to terminate the traversal, which is then returned
+template <typename LeafFunc>
+CU_DEVICE bool VisitLeaf(uint32_t first, uint32_t num_primitives, const uint32_t *primitive_ids, LeafFunc &&on_leaf) {
+    for (uint32_t i = first; i < first + num_primitives; i++) {
+        if (on_leaf(primitive_ids ? primitive_ids[i] : i)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename LeafFunc>
+CU_DEVICE bool VisitPackedLeaf(uint32_t child, const uint32_t *primitive_ids, LeafFunc &&on_leaf) {
+    auto first = child & kAccelLeafFirstMask;
+    auto num_primitives = ((child & ~kAccelLeafBit) >> kAccelLeafSizeShift) + 1;
+    return VisitLeaf(first, num_primitives, primitive_ids, on_leaf);
+}
+
+// the child of internal node `u` whose center lies nearer along the ray
+CU_DEVICE uint32_t NearChild(const AccelNode *nodes, const Bbox *bboxes, uint32_t u, const Ray &ray) {
+    auto lc = nodes[u].lc_or_id;
+    auto rc = nodes[u].rc;
+    auto offset = (bboxes[rc].pmin + bboxes[rc].pmax) - (bboxes[lc].pmin + bboxes[lc].pmax);
+    return glm::dot(glm::vec3(offset), ray.direction) >= 0.0f ? lc : rc;
+}
+
+CU_DEVICE uint32_t SiblingOf(const AccelNode *nodes, uint32_t pa, uint32_t u) {
+    return nodes[pa].lc_or_id == u ? nodes[pa].rc : nodes[pa].lc_or_id;
+}
+
+// any-hit traversal visits the child nearer along the ray first, as blockers near the origin of shadow rays
+// are common, closest-hit traversal does not order children
+template <bool AnyHit = false, typename LeafFunc>
+CU_DEVICE bool TraverseBinary(const AccelNode *nodes, const Bbox *bboxes, const uint32_t *primitive_ids,
+    const Ray &ray, LeafFunc &&on_leaf) {
+    uint32_t stack[kAccelStackSize];
+    stack[0] = 0;
+    uint32_t sp = 1;
+    while (sp > 0) {
+        auto u = stack[--sp];
+        if (BboxIntersect(bboxes[u].pmin, bboxes[u].pmax, ray)) {
+            if (nodes[u].IsLeaf()) {
+                if (VisitLeaf(nodes[u].lc_or_id, nodes[u].NumPrimitives(), primitive_ids, on_leaf)) {
+                    return true;
+                }
+            } else if constexpr (AnyHit) {
+                auto near = NearChild(nodes, bboxes, u, ray);
+                stack[sp++] = SiblingOf(nodes, u, near);
+                stack[sp++] = near;
+            } else {
+                stack[sp++] = nodes[u].lc_or_id;
+                stack[sp++] = nodes[u].rc;
+            }
+        }
+    }
+    return false;
+}
+
+// walks the tree with parent links, so that it needs constant state at any depth (Hapala et al. 2011),
+// a node is entered either from its parent as the near child or from its sibling as the far child,
+// and is left upwards once both children are done
+template <typename LeafFunc>
+CU_DEVICE bool TraverseStackless(const AccelNode *nodes, const Bbox *bboxes, const uint32_t *parents,
+    const uint32_t *primitive_ids, const Ray &ray, LeafFunc &&on_leaf) {
+    if (!BboxIntersect(bboxes[0].pmin, bboxes[0].pmax, ray)) {
+        return false;
+    }
+    if (nodes[0].IsLeaf()) {
+        return VisitLeaf(nodes[0].lc_or_id, nodes[0].NumPrimitives(), primitive_ids, on_leaf);
+    }
+
+    enum struct State {
+        eFromParent,
+        eFromSibling,
+        eFromChild,
+    };
+    auto u = NearChild(nodes, bboxes, 0, ray);
+    auto state = State::eFromParent;
+    while (true) {
+        if (state == State::eFromChild) {
+            if (u == 0) {
+                return false;
+            }
+            auto pa = parents[u];
+            if (u == NearChild(nodes, bboxes, pa, ray)) {
+                u = SiblingOf(nodes, pa, u);
+                state = State::eFromSibling;
+            } else {
+                u = pa;
+            }
+            continue;
+        }
+
+        if (BboxIntersect(bboxes[u].pmin, bboxes[u].pmax, ray)) {
+            if (!nodes[u].IsLeaf()) {
+                u = NearChild(nodes, bboxes, u, ray);
+                state = State::eFromParent;
+                continue;
+            }
+            if (VisitLeaf(nodes[u].lc_or_id, nodes[u].NumPrimitives(), primitive_ids, on_leaf)) {
+                return true;
+            }
+        }
+        if (state == State::eFromParent) {
+            u = SiblingOf(nodes, parents[u], u);
+            state = State::eFromSibling;
+        } else {
+            u = parents[u];
+            state = State::eFromChild;
+        }
+    }
+}
+
+template <uint32_t Width>
+CU_DEVICE void WideChildBbox(const AccelWideNode<Width> &node, const glm::vec3 &, uint32_t i, glm::vec3 &pmin,
+    glm::vec3 &pmax) {
+    pmin = glm::vec3(node.pmin_x[i], node.pmin_y[i], node.pmin_z[i]);
+    pmax = glm::vec3(node.pmax_x[i], node.pmax_y[i], node.pmax_z[i]);
+}
+
+CU_DEVICE void WideChildBbox(const AccelQuantizedNode &node, const glm::vec3 &scale, uint32_t i, glm::vec3 &pmin,
+    glm::vec3 &pmax) {
+    pmin = node.origin + glm::vec3(node.qmin_x[i], node.qmin_y[i], node.qmin_z[i]) * scale;
+    pmax = node.origin + glm::vec3(node.qmax_x[i], node.qmax_y[i], node.qmax_z[i]) * scale;
+}
+
+template <uint32_t Width>
+CU_DEVICE glm::vec3 WideNodeScale(const AccelWideNode<Width> &) {
+    return glm::vec3(1.0f);
+}
+
+CU_DEVICE glm::vec3 WideNodeScale(const AccelQuantizedNode &node) {
+    return node.Scale();
+}
+
+// hit children are visited from near to far, which shrinks `tmax` early for closest-hit traversal and reaches
+// blockers near the origin of shadow rays sooner for any-hit traversal
+template <uint32_t Width, typename WideNode, typename LeafFunc>
+CU_DEVICE bool TraverseWide(const WideNode *nodes, const uint32_t *primitive_ids, const Ray &ray,
+    LeafFunc &&on_leaf) {
+    auto inv_dir = 1.0f / ray.direction;
+    uint32_t stack[kAccelWideStackSize];
+    stack[0] = 0;
+    uint32_t sp = 1;
+    while (sp > 0) {
+        auto u = stack[--sp];
+        if (u & kAccelLeafBit) {
+            if (VisitPackedLeaf(u, primitive_ids, on_leaf)) {
+                return true;
+            }
+            continue;
+        }
+
+        const auto &node = nodes[u];
+        auto scale = WideNodeScale(node);
+        float hit_t[Width];
+        uint32_t hit_children[Width];
+        uint32_t num_hits = 0;
+        for (uint32_t i = 0; i < Width && node.children[i] != kAccelInvalidChild; i++) {
+            glm::vec3 pmin, pmax;
+            WideChildBbox(node, scale, i, pmin, pmax);
+            float t;
+            if (!BboxIntersect(pmin, pmax, ray, inv_dir, t)) {
+                continue;
+            }
+            // keep hits sorted from far to near so that the nearest child is popped first
+            auto j = num_hits++;
+            while (j > 0 && hit_t[j - 1] < t) {
+                hit_t[j] = hit_t[j - 1];
+                hit_children[j] = hit_children[j - 1];
+                --j;
+            }
+            hit_t[j] = t;
+            hit_children[j] = node.children[i];
+        }
+        for (uint32_t i = 0; i < num_hits; i++) {
+            stack[sp++] = hit_children[i];
+        }
+    }
+    return false;
+}
+
+// the nearer hit child is visited first, which suits both closest-hit and any-hit traversal
+template <typename LeafFunc>
+CU_DEVICE bool TraverseCompact(const AccelCompactNode *nodes, const uint32_t *primitive_ids, const Ray &ray,
+    LeafFunc &&on_leaf) {
+    auto inv_dir = 1.0f / ray.direction;
+    uint32_t stack[kAccelStackSize];
+    uint32_t sp = 0;
+    uint32_t u = 0;
+    while (true) {
+        if (u & kAccelLeafBit) {
+            if (VisitPackedLeaf(u, primitive_ids, on_leaf)) {
+                return true;
+            }
+        } else {
+            const auto &node = nodes[u];
+            float l_t, r_t;
+            auto l_hit = node.lc != kAccelInvalidChild && BboxIntersect(node.lc_pmin, node.lc_pmax, ray, inv_dir, l_t);
+            auto r_hit = node.rc != kAccelInvalidChild && BboxIntersect(node.rc_pmin, node.rc_pmax, ray, inv_dir, r_t);
+            if (l_hit && r_hit) {
+                u = l_t <= r_t ? node.lc : node.rc;
+                stack[sp++] = l_t <= r_t ? node.rc : node.lc;
+                continue;
+            } else if (l_hit) {
+                u = node.lc;
+                continue;
+            } else if (r_hit) {
+                u = node.rc;
+                continue;
+            }
+        }
+        if (sp == 0) {
+            break;
+        }
+        u = stack[--sp];
+    }
+    return false;
+}
+
+template <bool AnyHit = false, typename LeafFunc>
+CU_DEVICE bool TraverseAccel(AccelLayout layout, const AccelNode *nodes, const Bbox *bboxes,
+    const uint32_t *primitive_ids, const void *packed_nodes, const Ray &ray, LeafFunc &&on_leaf) {
+    switch (layout) {
+        case AccelLayout::eWide4:
+            return TraverseWide<4>(reinterpret_cast<const AccelWideNode<4> *>(packed_nodes), primitive_ids, ray,
+                on_leaf);
+        case AccelLayout::eWide8:
+            return TraverseWide<8>(reinterpret_cast<const AccelWideNode<8> *>(packed_nodes), primitive_ids, ray,
+                on_leaf);
+        case AccelLayout::eQuantized:
+            return TraverseWide<kAccelMaxWidth>(reinterpret_cast<const AccelQuantizedNode *>(packed_nodes),
+                primitive_ids, ray, on_leaf);
+        case AccelLayout::eCompact:
+            return TraverseCompact(reinterpret_cast<const AccelCompactNode *>(packed_nodes), primitive_ids, ray,
+                on_leaf);
+        case AccelLayout::eStackless:
+            return TraverseStackless(nodes, bboxes, reinterpret_cast<const uint32_t *>(packed_nodes), primitive_ids,
+                ray, on_leaf);
+        default:
+            return TraverseBinary<AnyHit>(nodes, bboxes, primitive_ids, ray, on_leaf);
+    }
+}
+
+}
+
+// leaves refer to primitives of `geometry` by their position in BVH leaf order
+struct AccelBottom {
+    AccelLayout layout;
+    AccelNode *nodes;
+    Bbox *bboxes;
+    void *packed_nodes;
+    Geometry geometry;
+
+    CU_DEVICE bool Intersect(Ray &ray, AccelHitInfo &hit_info) const {
+        bool intersected = false;
+        TraverseAccel(layout, nodes, bboxes, nullptr, packed_nodes, ray, [&](uint32_t index) {
+            float t;
+            uint32_t prim_id;
+            if (geometry.Intersect(ray, index, t, hit_info.attribs, prim_id)) {
+                ray.tmax = t;
+                hit_info.primitive_id = prim_id;
+                intersected = true;
+            }
+            return false;
+        });
+        return intersected;
+    }
+
+    // `occluder_index` is set to the position in BVH leaf order of the primitive blocking the ray if there is one
+    CU_DEVICE bool Occlude(const Ray &ray, uint32_t &occluder_index) const {
+        return TraverseAccel<true>(layout, nodes, bboxes, nullptr, packed_nodes, ray, [&](uint32_t index) {
+            if (OccludedBy(ray, index)) {
+                occluder_index = index;
+                return true;
+            }
+            return false;
+        });
+    }
+
+    CU_DEVICE bool Occlude(const Ray &ray) const {
+        uint32_t occluder_index;
+        return Occlude(ray, occluder_index);
+    }
+
+    CU_DEVICE bool OccludedBy(const Ray &ray, uint32_t index) const {
+        float t;
+        glm::vec2 attribs;
+        uint32_t prim_id;
+        return geometry.Intersect(ray, index, t, attribs, prim_id);
+    }
+};
+
+struct AccelTop {
+    AccelLayout layout;
+    AccelNode *nodes;
+    Bbox *bboxes;
+    uint32_t *primitive_ids;
+    void *packed_nodes;
+    struct Instance {
+        AccelBottom *accel;
+        // affine, world to object
+        glm::mat4x3 transform_inv;
+        // object space bbox, tested before the BVH of a rotated instance is entered as its world space bbox
+        // in the instance BVH may be much larger
+        glm::vec3 local_pmin;
+        glm::vec3 local_pmax;
+        bool rotated;
+        // coarser levels of detail from 1 to `num_lods`, where level `i` drops details up to `lod_error * 2^(i-1)`
+        // in world space and is used for rays whose footprint on the instance is larger than that
+        AccelBottom **lods;
+        uint32_t num_lods;
+        float lod_error;
+
+        // false if the ray transformed to object space misses the instance for sure
+        CU_DEVICE bool MayHit(const Ray &local_ray) const {
+            return !rotated || BboxIntersect(local_pmin, local_pmax, local_ray);
+        }
+
+        // `lod_sample` in [0, 1) picks one of the two levels around the footprint at random in proportion to
+        // how close it is to them, so that levels blend over distance instead of switching at once
+        CU_DEVICE uint32_t SelectLod(const Ray &local_ray, const RayCone &cone, float lod_sample) const {
+            if (num_lods == 0 || (cone.width == 0.0f && cone.spread == 0.0f)) {
+                return 0;
+            }
+            float t;
+            BboxIntersect(local_pmin, local_pmax, local_ray, 1.0f / local_ray.direction, t);
+            auto footprint = cone.WidthAt(fmax(t, 0.0f));
+            auto level = floorf(log2f(fmax(footprint / lod_error, 0.5f)) + lod_sample);
+            return static_cast<uint32_t>(glm::clamp(level, 0.0f, static_cast<float>(num_lods)));
+        }
+
+        CU_DEVICE const AccelBottom *Lod(uint32_t lod) const {
+            return lod == 0 ? accel : lods[lod - 1];
+        }
+    } *instances;
+    // a single instance is traversed directly, without the instance BVH
+    uint32_t num_instances;
+
+    // levels of detail of instances are selected by `cone` and `lod_sample`, see `Instance::SelectLod`,
+    // the full meshes are used if `cone` is empty
+    CU_DEVICE bool Intersect(Ray &ray, AccelHitInfo &hit_info, const RayCone &cone = {},
+        float lod_sample = 0.0f) const {
+        auto intersect_instance = [&](uint32_t inst_id) {
+            const auto &inst = instances[inst_id];
+            auto local_ray = TransformRay(ray, inst.transform_inv);
+            if (!inst.MayHit(local_ray)) {
+                return false;
+            }
+            auto lod = inst.SelectLod(local_ray, cone, lod_sample);
+            if (!inst.Lod(lod)->Intersect(local_ray, hit_info)) {
+                return false;
+            }
+            ray.tmax = local_ray.tmax;
+            hit_info.instance_id = inst_id;
+            hit_info.lod = lod;
+            return true;
+        };
+
+        if (num_instances == 1) {
+            return intersect_instance(0);
+        }
+
+        bool intersected = false;
+        TraverseAccel(layout, nodes, bboxes, primitive_ids, packed_nodes, ray, [&](uint32_t inst_id) {
+            intersected |= intersect_instance(inst_id);
+            return false;
+        });
+        return intersected;
+    }
+
+    // `occluder` is tested before traversing and is updated to the primitive blocking the ray if there is one
+    CU_DEVICE bool Occlude(const Ray &ray, AccelOccluder &occluder, const RayCone &cone = {},
+        float lod_sample = 0.0f) const {
+        // the cached primitive only counts if this ray selects the same level of detail as traversal would
+        if (occluder.instance_id < num_instances) {
+            const auto &inst = instances[occluder.instance_id];
+            auto local_ray = TransformRay(ray, inst.transform_inv);
+            if (inst.SelectLod(local_ray, cone, lod_sample) == occluder.lod
+                && inst.Lod(occluder.lod)->OccludedBy(local_ray, occluder.index)) {
+                return true;
+            }
+        }
+
+        auto occlude_instance = [&](uint32_t inst_id) {
+            const auto &inst = instances[inst_id];
+            auto local_ray = TransformRay(ray, inst.transform_inv);
+            if (!inst.MayHit(local_ray)) {
+                return false;
+            }
+            auto lod = inst.SelectLod(local_ray, cone, lod_sample);
+            if (!inst.Lod(lod)->Occlude(local_ray, occluder.index)) {
+                return false;
+            }
+            occluder.instance_id = inst_id;
+            occluder.lod = lod;
+            return true;
+        };
+
+        if (num_instances == 1) {
+            return occlude_instance(0);
+        }
+        return TraverseAccel<true>(layout, nodes, bboxes, primitive_ids, packed_nodes, ray, occlude_instance);
+    }
+
+    CU_DEVICE bool Occlude(const Ray &ray) const {
+        AccelOccluder occluder { kAccelInvalidOccluder, 0, 0 };
+        return Occlude(ray, occluder);
+    }
+};
+
+}
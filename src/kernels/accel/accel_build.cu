@@ -1,208 +1,594 @@
-#include "accel_build.cuh"
-
-#include <memory>
-
-#include <thrust/sort.h>
-
-#include "cuda_helpers/buffer.hpp"
-
-namespace kernel {
-
-namespace {
-
-constexpr float kMortonCodeResolution = 1024.0f;
-
-constexpr uint32_t kThreads = 32;
-
-CU_DEVICE uint32_t MortonCode3(uint32_t x) {
-    x = (x ^ (x << 16)) & 0xff0000ff;
-	x = (x ^ (x << 8)) & 0x0300f00f;
-	x = (x ^ (x << 4)) & 0x030c30c3;
-	x = (x ^ (x << 2)) & 0x09249249;
-    return x;
-}
-
-CU_GLOBAL void CalcMortonCode(uint64_t *codes, const Bbox *bboxes, Bbox merged_bbox, uint32_t num_primitives) {
-    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
-    if (index >= num_primitives) {
-        return;
-    }
-
-    auto center = (bboxes[index].pmin + bboxes[index].pmax) * 0.5f;
-    auto scale = merged_bbox.pmax - merged_bbox.pmin;
-    auto p = (center - merged_bbox.pmin) / scale;
-
-    auto x = MortonCode3(fmin(p.x * kMortonCodeResolution, kMortonCodeResolution - 1));
-    auto y = MortonCode3(fmin(p.y * kMortonCodeResolution, kMortonCodeResolution - 1));
-    auto z = MortonCode3(fmin(p.z * kMortonCodeResolution, kMortonCodeResolution - 1));
-    uint64_t morton_code = (x << 2) | (y << 1) | z;
-
-    codes[index] = (morton_code << 32) | index;
-}
-
-CU_GLOBAL void FillLeafNodes(AccelNode *nodes, const uint64_t *codes, uint32_t num_primitives) {
-    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
-    if (index >= num_primitives) {
-        return;
-    }
-
-    nodes[index].lc_or_id = codes[index];
-    nodes[index].rc = ~0u;
-}
-
-CU_DEVICE uint32_t Lcp(uint64_t a, uint64_t b) {
-    return __clzll(a ^ b);
-}
-
-CU_DEVICE glm::uvec2 FindNodeRange(uint32_t index, const uint64_t *codes, uint32_t num_primitives) {
-    if (index == 0) {
-        return glm::uvec2(0, num_primitives - 1);
-    }
-
-    auto code = codes[index];
-    auto l_lcp = Lcp(code, codes[index - 1]);
-    auto r_lcp = Lcp(code, codes[index + 1]);
-    
-    auto d = l_lcp > r_lcp ? -1 : 1;
-    auto min_lcp = glm::min(l_lcp, r_lcp);
-    uint32_t step = 1;
-    uint32_t j_lcp;
-    do {
-        step <<= 1;
-        int j = index + d * step;
-        j_lcp = 0;
-        if (j >= 0 && j < num_primitives) {
-            j_lcp = Lcp(code, codes[j]);
-        }
-    } while (j_lcp > min_lcp);
-
-    auto l = step >> 1;
-    auto r = glm::min(step, d == -1 ? index : num_primitives - 1 - index);
-    while (l < r) {
-        auto mid = l + ((r - l) >> 1) + 1;
-        auto j = index + d * mid;
-        auto j_lcp = Lcp(code, codes[j]);
-        if (j_lcp < min_lcp) {
-            r = mid - 1;
-        } else {
-            l = mid;
-        }
-    }
-
-    r = index + d * l;
-    l = index;
-    return l <= r ? glm::uvec2(l, r) : glm::uvec2(r, l);
-}
-
-CU_DEVICE uint32_t FindNodeLeftChild(uint32_t index, glm::uvec2 range, const uint64_t *codes, uint32_t num_primitives) {
-    auto l_code = codes[range.x];
-    auto r_code = codes[range.y];
-    auto node_lcp = Lcp(l_code, r_code);
-
-    auto l = range.x;
-    auto r = range.y;
-    while (l < r) {
-        auto mid = l + ((r - l) >> 1);
-        auto m_lcp = Lcp(l_code, codes[mid]);
-        if (m_lcp > node_lcp) {
-            l = mid + 1;
-        } else {
-            r = mid;
-        }
-    }
-
-    return l - 1;
-}
-
-CU_GLOBAL void BuildInternalNodes(AccelNode *nodes, uint32_t *parents, const uint64_t *codes, uint32_t num_primitives) {
-    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
-    if (index >= num_primitives - 1) {
-        return;
-    }
-
-    auto range = FindNodeRange(index, codes, num_primitives);
-    auto lc = FindNodeLeftChild(index, range, codes, num_primitives);
-    auto rc = lc + 1;
-
-    if (lc == range.x) {
-        lc += num_primitives - 1;
-    }
-    if (rc == range.y) {
-        rc += num_primitives - 1;
-    }
-
-    nodes[index].lc_or_id = lc;
-    nodes[index].rc = rc;
-    parents[lc] = index;
-    parents[rc] = index;
-}
-
-CU_GLOBAL void InitInternalNodesBbox(Bbox *bboxes, Bbox merged_bbox, uint32_t num_primitives) {
-    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
-    if (index >= num_primitives - 1) {
-        return;
-    }
-
-    bboxes[index].pmin = merged_bbox.pmax;
-    bboxes[index].pmax = merged_bbox.pmin;
-}
-
-CU_DEVICE float atomicMinFloat(float *addr, float value) {
-    return !signbit(value) ? __int_as_float(atomicMin(reinterpret_cast<int *>(addr), __float_as_int(value))) :
-        __uint_as_float(atomicMax(reinterpret_cast<uint32_t *>(addr), __float_as_uint(value)));
-}
-
-CU_DEVICE float atomicMaxFloat(float *addr, float value) {
-    return !signbit(value) ? __int_as_float(atomicMax(reinterpret_cast<int *>(addr), __float_as_int(value))) :
-        __uint_as_float(atomicMin(reinterpret_cast<uint32_t *>(addr), __float_as_uint(value)));
-}
-
-CU_GLOBAL void CalcInternalNodesBbox(const uint32_t *parents, Bbox *bboxes, uint32_t num_primitives) {
-    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
-    if (index >= num_primitives) {
-        return;
-    }
-
-    uint32_t u = num_primitives - 1 + index;
-    uint32_t pa = parents[u];
-    auto bbox = bboxes[u];
-    while (u != 0) {
-        atomicMinFloat(&bboxes[pa].pmin.x, bbox.pmin.x);
-        atomicMinFloat(&bboxes[pa].pmin.y, bbox.pmin.y);
-        atomicMinFloat(&bboxes[pa].pmin.z, bbox.pmin.z);
-        atomicMaxFloat(&bboxes[pa].pmax.x, bbox.pmax.x);
-        atomicMaxFloat(&bboxes[pa].pmax.y, bbox.pmax.y);
-        atomicMaxFloat(&bboxes[pa].pmax.z, bbox.pmax.z);
-
-        u = pa;
-        pa = parents[u];
-    }
-}
-
-}
-
-void BuildAccel(AccelNode *nodes, Bbox *bboxes, Bbox merged_bbox, uint32_t num_primitives) {
-    auto num_internal_nodes = num_primitives - 1;
-
-    auto morton_codes_buffer = std::make_unique<CuBuffer>(sizeof(uint64_t) * num_primitives);
-    auto morton_codes = morton_codes_buffer->TypedGpuData<uint64_t>();
-    auto bboxes_leaf = bboxes + num_internal_nodes;
-    CalcMortonCode<<<(num_primitives + kThreads - 1) / kThreads, kThreads>>>(
-        morton_codes, bboxes_leaf, merged_bbox, num_primitives);
-
-    thrust::sort_by_key(thrust::device, morton_codes, morton_codes + num_primitives, bboxes_leaf);
-
-    auto nodes_leaf = nodes + num_internal_nodes;
-    FillLeafNodes<<<(num_primitives + kThreads - 1) / kThreads, kThreads>>>(nodes_leaf, morton_codes, num_primitives);
-
-    auto parents_buffer = std::make_unique<CuBuffer>(sizeof(uint32_t) * (num_primitives + num_internal_nodes));
-    auto parents = parents_buffer->TypedGpuData<uint32_t>();
-    BuildInternalNodes<<<(num_internal_nodes + kThreads - 1) / kThreads, kThreads>>>(
-        nodes, parents, morton_codes, num_primitives);
-
-    InitInternalNodesBbox<<<(num_internal_nodes + kThreads - 1) / kThreads, kThreads>>>(
-        bboxes, merged_bbox, num_primitives);
-    CalcInternalNodesBbox<<<(num_primitives + kThreads - 1) / kThreads, kThreads>>>(parents, bboxes, num_primitives);
-}
-
-}
+#include "accel_build_common.cuh"
+
+#include <algorithm>
+#include <vector>
+
+#include <thrust/functional.h>
+#include <thrust/gather.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/sequence.h>
+#include <thrust/system/cuda/execution_policy.h>
+
+namespace kernel {
+
+namespace {
+
+using CentroidIterator = thrust::transform_iterator<BboxCentroidOp, const Bbox *>;
+
+CU_GLOBAL void CalcMortonCode(uint64_t *codes, const Bbox *bboxes, Bbox centroid_bounds, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+
+    codes[index] = MortonCodeOf(bboxes[index], centroid_bounds);
+}
+
+CU_GLOBAL void FillLeafNodes(AccelNode *nodes, Bbox *bboxes, const uint32_t *prim_ids, const Bbox *prim_bboxes,
+    uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+
+    auto prim_id = prim_ids[index];
+    nodes[index] = AccelLeafNode(prim_id, 1);
+    bboxes[index] = prim_bboxes[prim_id];
+}
+
+CU_DEVICE void BuildInternalNode(uint32_t index, AccelNode *nodes, uint32_t *parents, const uint64_t *codes,
+    uint32_t num_primitives) {
+    auto range = FindNodeRange(index, codes, num_primitives);
+    auto lc = FindNodeLeftChild(index, range, codes, num_primitives);
+    auto rc = lc + 1;
+
+    if (lc == range.x) {
+        lc += num_primitives - 1;
+    }
+    if (rc == range.y) {
+        rc += num_primitives - 1;
+    }
+
+    nodes[index].lc_or_id = lc;
+    nodes[index].rc = rc;
+    parents[lc] = index;
+    parents[rc] = index;
+}
+
+CU_GLOBAL void BuildInternalNodes(AccelNode *nodes, uint32_t *parents, const uint64_t *codes, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives - 1) {
+        return;
+    }
+
+    BuildInternalNode(index, nodes, parents, codes, num_primitives);
+}
+
+CU_GLOBAL void CalcParents(const AccelNode *nodes, uint32_t *parents, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives - 1) {
+        return;
+    }
+
+    parents[nodes[index].lc_or_id] = index;
+    parents[nodes[index].rc] = index;
+}
+
+// walks up from leaf `u`, the second thread arriving at a node merges the bboxes of its children, which are both
+// done by then, and continues upwards, so that each internal node is written once without atomics on bboxes,
+// `visits` of internal nodes start from 0
+CU_DEVICE void PropagateLeafBbox(uint32_t u, const AccelNode *nodes, const uint32_t *parents, Bbox *bboxes,
+    uint32_t *visits) {
+    while (u != 0) {
+        u = parents[u];
+        __threadfence();
+        if (atomicAdd(&visits[u], 1u) == 0) {
+            return;
+        }
+        __threadfence();
+
+        bboxes[u] = BboxMergeOp {}(LoadBboxVolatile(bboxes[nodes[u].lc_or_id]), LoadBboxVolatile(bboxes[nodes[u].rc]));
+    }
+}
+
+CU_GLOBAL void CalcInternalNodesBbox(const AccelNode *nodes, const uint32_t *parents, Bbox *bboxes,
+    uint32_t *visits, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+
+    PropagateLeafBbox(num_primitives - 1 + index, nodes, parents, bboxes, visits);
+}
+
+CU_GLOBAL void CalcNodesSahCost(const AccelNode *nodes, const Bbox *bboxes, float *costs, uint32_t num_nodes) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_nodes) {
+        return;
+    }
+
+    costs[index] = SahNodeCost(nodes[index], bboxes[index]);
+}
+
+size_t AccelLbvhScratchSize(uint32_t num_primitives) {
+    return CuScratch::PieceSize(sizeof(uint64_t) * num_primitives) + SortLeavesScratchSize(num_primitives)
+        + CuScratch::PieceSize(sizeof(uint32_t) * (2 * num_primitives - 1))
+        + UpdateInternalNodesBboxScratchSize(num_primitives);
+}
+
+void BuildAccelLbvh(AccelNode *nodes, Bbox *bboxes, uint32_t num_primitives, CuScratch &scratch) {
+    auto num_internal_nodes = num_primitives - 1;
+
+    CuScratch::Scope scope(scratch);
+    auto morton_codes = scratch.Allocate<uint64_t>(num_primitives);
+    SortLeavesByMortonCode(nodes, bboxes, morton_codes, num_primitives, scratch);
+
+    auto parents = scratch.Allocate<uint32_t>(num_primitives + num_internal_nodes);
+    auto threads = BlockSizeOf<BuildInternalNodes>();
+    BuildInternalNodes<<<(num_internal_nodes + threads - 1) / threads, threads>>>(
+        nodes, parents, morton_codes, num_primitives);
+
+    UpdateInternalNodesBbox(nodes, parents, bboxes, num_primitives, scratch);
+}
+
+}
+
+CuScratch &AccelScratchOrDefault(CuScratch *scratch) {
+    static CuScratch default_scratch;
+    return scratch != nullptr ? *scratch : default_scratch;
+}
+
+size_t SortLeavesScratchSize(uint32_t num_primitives) {
+    auto reduce_size = ReduceScratchSize<Bbox, CentroidIterator, BboxMergeOp>(num_primitives);
+    auto sort_size = CuScratch::PieceSize(sizeof(uint32_t) * num_primitives)
+        + SortPairsScratchSize<uint64_t, uint32_t>(num_primitives)
+        + CuScratch::PieceSize(sizeof(Bbox) * num_primitives);
+    return std::max(reduce_size, sort_size);
+}
+
+void SortLeavesByMortonCode(AccelNode *nodes, Bbox *bboxes, uint64_t *morton_codes, uint32_t num_primitives,
+    CuScratch &scratch) {
+    auto num_internal_nodes = num_primitives - 1;
+    auto bboxes_leaf = bboxes + num_internal_nodes;
+
+    Bbox empty_bbox {
+        .pmin = glm::vec4(FLT_MAX, FLT_MAX, FLT_MAX, 1.0f),
+        .pmax = glm::vec4(-FLT_MAX, -FLT_MAX, -FLT_MAX, 1.0f),
+    };
+    CuScratch::Scope scope(scratch);
+    auto centroid_bounds = Reduce(CentroidIterator(bboxes_leaf, BboxCentroidOp {}), num_primitives, BboxMergeOp {},
+        empty_bbox, scratch);
+    auto threads = BlockSizeOf<CalcMortonCode>();
+    CalcMortonCode<<<(num_primitives + threads - 1) / threads, threads>>>(
+        morton_codes, bboxes_leaf, centroid_bounds, num_primitives);
+
+    auto prim_ids = scratch.Allocate<uint32_t>(num_primitives);
+    thrust::sequence(thrust::cuda::par(scratch), prim_ids, prim_ids + num_primitives);
+    SortPairs(morton_codes, prim_ids, num_primitives, scratch);
+
+    auto prim_bboxes = scratch.Allocate<Bbox>(num_primitives);
+    cudaMemcpy(prim_bboxes, bboxes_leaf, sizeof(Bbox) * num_primitives, cudaMemcpyDeviceToDevice);
+    threads = BlockSizeOf<FillLeafNodes>();
+    FillLeafNodes<<<(num_primitives + threads - 1) / threads, threads>>>(
+        nodes + num_internal_nodes, bboxes_leaf, prim_ids, prim_bboxes, num_primitives);
+}
+
+void CalcAccelParents(const AccelNode *nodes, uint32_t *parents, uint32_t num_primitives) {
+    if (num_primitives > 1) {
+        auto threads = BlockSizeOf<CalcParents>();
+        CalcParents<<<(num_primitives - 1 + threads - 1) / threads, threads>>>(nodes, parents, num_primitives);
+    }
+}
+
+size_t UpdateInternalNodesBboxScratchSize(uint32_t num_primitives) {
+    return CuScratch::PieceSize(sizeof(uint32_t) * (num_primitives - 1));
+}
+
+void UpdateInternalNodesBbox(const AccelNode *nodes, const uint32_t *parents, Bbox *bboxes, uint32_t num_primitives,
+    CuScratch &scratch) {
+    if (num_primitives < 2) {
+        return;
+    }
+    auto num_internal_nodes = num_primitives - 1;
+    CuScratch::Scope scope(scratch);
+    auto visits = scratch.Allocate<uint32_t>(num_internal_nodes);
+    cudaMemset(visits, 0, sizeof(uint32_t) * num_internal_nodes);
+    auto threads = BlockSizeOf<CalcInternalNodesBbox>();
+    CalcInternalNodesBbox<<<(num_primitives + threads - 1) / threads, threads>>>(
+        nodes, parents, bboxes, visits, num_primitives);
+}
+
+uint32_t AccelMaxReferences(const AccelBuildOptions &options, uint32_t num_primitives) {
+    if (options.builder != AccelBuilder::eSbvh) {
+        return num_primitives;
+    }
+    return num_primitives + static_cast<uint32_t>(num_primitives * glm::max(options.max_spatial_split_growth, 0.0f));
+}
+
+namespace {
+
+// runs the optional passes over a built binary tree of `num_primitives` leaves and packs it
+AccelBuildStats FinishAccel(AccelNode *nodes, Bbox *bboxes, uint32_t num_primitives,
+    const AccelBuildOptions &options, void *packed_nodes, uint32_t *primitive_ids, CuScratch &scratch) {
+    AccelBuildStats stats { .num_leaves = num_primitives, .num_references = num_primitives };
+    auto max_leaf_size = glm::clamp(options.max_leaf_size, 1u, kAccelMaxLeafSize);
+    if (options.num_treelet_passes > 0 || (max_leaf_size > 1 && primitive_ids != nullptr)) {
+        stats.initial_sah_cost = CalcAccelSahCost(nodes, bboxes, num_primitives, &scratch);
+    }
+    if (options.num_treelet_passes > 0) {
+        OptimizeAccelTreelets(nodes, bboxes, num_primitives, options.num_treelet_passes, scratch);
+    }
+    if (primitive_ids != nullptr) {
+        stats.num_leaves = CollapseAccelLeaves(nodes, bboxes, primitive_ids, num_primitives, max_leaf_size, scratch);
+    }
+    stats.sah_cost = CalcAccelSahCost(nodes, bboxes, stats.num_leaves, &scratch);
+
+    if (options.layout != AccelLayout::eBinary) {
+        stats.layout = PackAccel(nodes, bboxes, stats.num_leaves, options.layout, packed_nodes, &scratch);
+    }
+
+    return stats;
+}
+
+}
+
+size_t AccelScratchSize(const AccelBuildOptions &options, uint32_t num_primitives) {
+    if (num_primitives == 0) {
+        return 0;
+    }
+    size_t build_size = 0;
+    switch (options.builder) {
+        case AccelBuilder::eLbvh:
+            build_size = AccelLbvhScratchSize(num_primitives);
+            break;
+        case AccelBuilder::eSah:
+            build_size = AccelSahScratchSize(num_primitives, options);
+            break;
+        case AccelBuilder::ePloc:
+            build_size = AccelPlocScratchSize(num_primitives);
+            break;
+        case AccelBuilder::eSbvh:
+            // `BuildAccel` builds it as `AccelBuilder::eSah`, `BuildAccelSpatial` runs the later passes over
+            // all references
+            build_size = AccelSahScratchSize(num_primitives, options);
+            num_primitives = AccelMaxReferences(options, num_primitives);
+            break;
+    }
+    // the passes after building run one after another, each taking back what it allocates, leaves are collapsed
+    // whenever primitive ids are given
+    return std::max({
+        build_size,
+        options.num_treelet_passes > 0 ? AccelTreeletScratchSize(num_primitives) : 0,
+        AccelCollapseScratchSize(num_primitives),
+        AccelSahCostScratchSize(num_primitives),
+        AccelPackScratchSize(num_primitives, options.layout),
+    });
+}
+
+AccelBuildStats BuildAccel(AccelNode *nodes, Bbox *bboxes, Bbox merged_bbox, uint32_t num_primitives,
+    const AccelBuildOptions &options, void *packed_nodes, uint32_t *primitive_ids, CuScratch *scratch) {
+    auto &build_scratch = AccelScratchOrDefault(scratch);
+    switch (options.builder) {
+        case AccelBuilder::eLbvh:
+            BuildAccelLbvh(nodes, bboxes, num_primitives, build_scratch);
+            break;
+        case AccelBuilder::eSah:
+        case AccelBuilder::eSbvh:
+            BuildAccelSah(nodes, bboxes, num_primitives, options, build_scratch);
+            break;
+        case AccelBuilder::ePloc:
+            BuildAccelPloc(nodes, bboxes, num_primitives, options, build_scratch);
+            break;
+    }
+
+    return FinishAccel(nodes, bboxes, num_primitives, options, packed_nodes, primitive_ids, build_scratch);
+}
+
+// spatial splits are searched on the CPU, the later passes run on the GPU as usual
+AccelBuildStats BuildAccelSpatial(AccelNode *nodes, Bbox *bboxes, const glm::vec3 *positions, const uint32_t *indices,
+    uint32_t num_triangles, const AccelBuildOptions &options, void *packed_nodes, uint32_t *primitive_ids,
+    CuScratch *scratch) {
+    auto num_max_nodes = 2 * AccelMaxReferences(options, num_triangles) - 1;
+    std::vector<AccelNode> host_nodes(num_max_nodes);
+    std::vector<Bbox> host_bboxes(num_max_nodes);
+    auto num_references = BuildAccelSbvhHost(host_nodes.data(), host_bboxes.data(), positions, indices,
+        num_triangles, options);
+    auto num_nodes = 2 * num_references - 1;
+    cudaMemcpy(nodes, host_nodes.data(), sizeof(AccelNode) * num_nodes, cudaMemcpyHostToDevice);
+    cudaMemcpy(bboxes, host_bboxes.data(), sizeof(Bbox) * num_nodes, cudaMemcpyHostToDevice);
+
+    return FinishAccel(nodes, bboxes, num_references, options, packed_nodes, primitive_ids,
+        AccelScratchOrDefault(scratch));
+}
+
+namespace {
+
+struct AccelBatchSegment {
+    TriMesh mesh;
+    AccelNode *nodes;
+    Bbox *bboxes;
+    // index of its first primitive among all primitives of the batch
+    uint32_t primitive_offset;
+    // index of its first node among all nodes of the batch
+    uint32_t node_offset;
+    uint32_t num_primitives;
+    // segments built by other builders are skipped after their leaf bboxes are calculated
+    bool lbvh;
+};
+
+// kernels of a batch run over all its primitives, each of them finds the segment it belongs to
+CU_DEVICE uint32_t FindBatchSegment(const AccelBatchSegment *segments, uint32_t num_segments, uint32_t index) {
+    uint32_t l = 0;
+    uint32_t r = num_segments - 1;
+    while (l < r) {
+        auto mid = (l + r + 1) / 2;
+        if (segments[mid].primitive_offset <= index) {
+            l = mid;
+        } else {
+            r = mid - 1;
+        }
+    }
+    return l;
+}
+
+CU_GLOBAL void CalcBatchLeafBboxes(const AccelBatchSegment *segments, uint32_t num_segments, Bbox *leaf_bboxes,
+    uint32_t *segment_ids, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+
+    auto segment_id = FindBatchSegment(segments, num_segments, index);
+    const auto &segment = segments[segment_id];
+    auto local_index = index - segment.primitive_offset;
+    const auto &mesh = segment.mesh;
+    auto p0 = mesh.GetPosition(mesh.indices[3 * local_index]);
+    auto p1 = mesh.GetPosition(mesh.indices[3 * local_index + 1]);
+    auto p2 = mesh.GetPosition(mesh.indices[3 * local_index + 2]);
+    Bbox bbox {
+        .pmin = glm::vec4(glm::min(p0, glm::min(p1, p2)), 1.0f),
+        .pmax = glm::vec4(glm::max(p0, glm::max(p1, p2)), 1.0f),
+    };
+    segment.bboxes[segment.num_primitives - 1 + local_index] = bbox;
+    leaf_bboxes[index] = bbox;
+    segment_ids[index] = segment_id;
+}
+
+CU_GLOBAL void CalcBatchMortonCodes(const Bbox *centroid_bounds, const Bbox *leaf_bboxes,
+    const uint32_t *segment_ids, uint64_t *codes, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+
+    codes[index] = MortonCodeOf(leaf_bboxes[index], centroid_bounds[segment_ids[index]]);
+}
+
+CU_GLOBAL void FillBatchLeafNodes(const AccelBatchSegment *segments, uint32_t num_segments, const uint32_t *prim_ids,
+    const Bbox *leaf_bboxes, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+
+    const auto &segment = segments[FindBatchSegment(segments, num_segments, index)];
+    if (!segment.lbvh) {
+        return;
+    }
+    auto local_index = index - segment.primitive_offset;
+    auto prim_id = prim_ids[index];
+    segment.nodes[segment.num_primitives - 1 + local_index] =
+        AccelLeafNode(prim_id - segment.primitive_offset, 1);
+    segment.bboxes[segment.num_primitives - 1 + local_index] = leaf_bboxes[prim_id];
+}
+
+CU_GLOBAL void BuildBatchInternalNodes(const AccelBatchSegment *segments, uint32_t num_segments, uint32_t *parents,
+    const uint64_t *codes, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+
+    const auto &segment = segments[FindBatchSegment(segments, num_segments, index)];
+    auto local_index = index - segment.primitive_offset;
+    if (!segment.lbvh || local_index >= segment.num_primitives - 1) {
+        return;
+    }
+    BuildInternalNode(local_index, segment.nodes, parents + segment.node_offset,
+        codes + segment.primitive_offset, segment.num_primitives);
+}
+
+CU_GLOBAL void CalcBatchInternalNodesBbox(const AccelBatchSegment *segments, uint32_t num_segments,
+    const uint32_t *parents, uint32_t *visits, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+
+    const auto &segment = segments[FindBatchSegment(segments, num_segments, index)];
+    if (!segment.lbvh) {
+        return;
+    }
+    auto local_index = index - segment.primitive_offset;
+    PropagateLeafBbox(segment.num_primitives - 1 + local_index, segment.nodes, parents + segment.node_offset,
+        segment.bboxes, visits + segment.node_offset);
+}
+
+size_t AccelLbvhBatchedScratchSize(uint32_t num_primitives, uint32_t num_nodes) {
+    return CuScratch::PieceSize(sizeof(uint64_t) * num_primitives * 2)
+        + CuScratch::PieceSize(sizeof(uint32_t) * num_primitives * 2)
+        + std::max(SortPairsScratchSize<uint64_t, uint32_t>(num_primitives),
+            SortPairsScratchSize<uint32_t, uint32_t>(num_primitives))
+        + CuScratch::PieceSize(sizeof(uint32_t) * num_nodes * 2);
+}
+
+// `centroid_bounds` bounds the leaf centroids of each segment
+void BuildAccelLbvhBatched(const AccelBatchSegment *segments, uint32_t num_segments, const Bbox *leaf_bboxes,
+    const uint32_t *segment_ids, const Bbox *centroid_bounds, uint32_t num_primitives, uint32_t num_nodes,
+    CuScratch &scratch) {
+    CuScratch::Scope scope(scratch);
+    auto codes = scratch.Allocate<uint64_t>(num_primitives * 2);
+    auto sorted_codes = codes + num_primitives;
+    auto threads = BlockSizeOf<CalcBatchMortonCodes>();
+    CalcBatchMortonCodes<<<(num_primitives + threads - 1) / threads, threads>>>(
+        centroid_bounds, leaf_bboxes, segment_ids, codes, num_primitives);
+
+    // sorted by codes and then stably by segments, primitives of each segment are in the same order
+    // as they are sorted when it is built alone
+    auto prim_ids = scratch.Allocate<uint32_t>(num_primitives * 2);
+    auto sorted_segment_ids = prim_ids + num_primitives;
+    cudaMemcpy(sorted_codes, codes, sizeof(uint64_t) * num_primitives, cudaMemcpyDeviceToDevice);
+    thrust::sequence(thrust::cuda::par(scratch), prim_ids, prim_ids + num_primitives);
+    SortPairs(sorted_codes, prim_ids, num_primitives, scratch);
+    thrust::gather(thrust::cuda::par(scratch), prim_ids, prim_ids + num_primitives, segment_ids, sorted_segment_ids);
+    SortPairs(sorted_segment_ids, prim_ids, num_primitives, scratch);
+    thrust::gather(thrust::cuda::par(scratch), prim_ids, prim_ids + num_primitives, codes, sorted_codes);
+
+    threads = BlockSizeOf<FillBatchLeafNodes>();
+    FillBatchLeafNodes<<<(num_primitives + threads - 1) / threads, threads>>>(
+        segments, num_segments, prim_ids, leaf_bboxes, num_primitives);
+
+    // parents and visit counters of each tree are at its node offset
+    auto parents = scratch.Allocate<uint32_t>(num_nodes * 2);
+    auto visits = parents + num_nodes;
+    cudaMemset(visits, 0, sizeof(uint32_t) * num_nodes);
+    threads = BlockSizeOf<BuildBatchInternalNodes>();
+    BuildBatchInternalNodes<<<(num_primitives + threads - 1) / threads, threads>>>(
+        segments, num_segments, parents, sorted_codes, num_primitives);
+    threads = BlockSizeOf<CalcBatchInternalNodesBbox>();
+    CalcBatchInternalNodesBbox<<<(num_primitives + threads - 1) / threads, threads>>>(
+        segments, num_segments, parents, visits, num_primitives);
+}
+
+}
+
+size_t AccelBatchScratchSize(const AccelBatchItem *items, uint32_t num_items) {
+    uint32_t num_primitives = 0;
+    uint32_t num_nodes = 0;
+    uint32_t num_segments = 0;
+    bool has_lbvh = false;
+    size_t items_size = 0;
+    for (uint32_t i = 0; i < num_items; i++) {
+        auto num_triangles = items[i].mesh.num_triangles;
+        if (num_triangles == 0) {
+            continue;
+        }
+        num_primitives += num_triangles;
+        num_nodes += 2 * num_triangles - 1;
+        ++num_segments;
+        has_lbvh |= items[i].options.builder == AccelBuilder::eLbvh;
+        items_size = std::max(items_size, AccelScratchSize(items[i].options, num_triangles));
+    }
+    auto batch_size = CuScratch::PieceSize(sizeof(AccelBatchSegment) * num_items)
+        + CuScratch::PieceSize(sizeof(Bbox) * num_primitives) + CuScratch::PieceSize(sizeof(uint32_t) * num_primitives)
+        + (has_lbvh ? CuScratch::PieceSize(sizeof(uint32_t) * (num_segments + 1))
+            + CuScratch::PieceSize(sizeof(Bbox) * num_segments)
+            + std::max(SegmentedReduceScratchSize<Bbox, CentroidIterator, BboxMergeOp>(num_segments),
+                AccelLbvhBatchedScratchSize(num_primitives, num_nodes)) : 0);
+    // trees are finished or built one by one after the shared buffers are taken back
+    return std::max(batch_size, items_size);
+}
+
+void BuildAccelBatched(const AccelBatchItem *items, uint32_t num_items, AccelBuildStats *stats, CuScratch *scratch) {
+    if (num_items == 0) {
+        return;
+    }
+    auto &build_scratch = AccelScratchOrDefault(scratch);
+
+    Bbox empty_bbox {
+        .pmin = glm::vec4(FLT_MAX, FLT_MAX, FLT_MAX, 1.0f),
+        .pmax = glm::vec4(-FLT_MAX, -FLT_MAX, -FLT_MAX, 1.0f),
+    };
+    // meshes without triangles have no tree and take no segment
+    std::vector<AccelBatchSegment> segments;
+    segments.reserve(num_items);
+    std::vector<uint32_t> segment_offsets;
+    segment_offsets.reserve(num_items + 1);
+    uint32_t num_primitives = 0;
+    uint32_t num_nodes = 0;
+    bool has_lbvh = false;
+    for (uint32_t i = 0; i < num_items; i++) {
+        auto num_triangles = items[i].mesh.num_triangles;
+        if (num_triangles == 0) {
+            continue;
+        }
+        segment_offsets.push_back(num_primitives);
+        segments.push_back(AccelBatchSegment {
+            .mesh = items[i].mesh,
+            .nodes = items[i].nodes,
+            .bboxes = items[i].bboxes,
+            .primitive_offset = num_primitives,
+            .node_offset = num_nodes,
+            .num_primitives = num_triangles,
+            .lbvh = items[i].options.builder == AccelBuilder::eLbvh,
+        });
+        num_primitives += num_triangles;
+        num_nodes += 2 * num_triangles - 1;
+        has_lbvh |= segments.back().lbvh;
+    }
+    segment_offsets.push_back(num_primitives);
+
+    uint32_t num_segments = segments.size();
+    if (num_segments > 0) {
+        CuScratch::Scope scope(build_scratch);
+        auto segments_gpu = build_scratch.Allocate<AccelBatchSegment>(num_segments);
+        cudaMemcpy(segments_gpu, segments.data(), sizeof(AccelBatchSegment) * num_segments,
+            cudaMemcpyHostToDevice);
+        auto leaf_bboxes = build_scratch.Allocate<Bbox>(num_primitives);
+        auto segment_ids = build_scratch.Allocate<uint32_t>(num_primitives);
+        auto threads = BlockSizeOf<CalcBatchLeafBboxes>();
+        CalcBatchLeafBboxes<<<(num_primitives + threads - 1) / threads, threads>>>(
+            segments_gpu, num_segments, leaf_bboxes, segment_ids, num_primitives);
+
+        if (has_lbvh) {
+            // Morton codes of each tree are relative to the bounds of its own centroids
+            auto segment_offsets_gpu = build_scratch.Allocate<uint32_t>(num_segments + 1);
+            cudaMemcpy(segment_offsets_gpu, segment_offsets.data(), sizeof(uint32_t) * (num_segments + 1),
+                cudaMemcpyHostToDevice);
+            auto centroid_bounds = build_scratch.Allocate<Bbox>(num_segments);
+            SegmentedReduce(CentroidIterator(leaf_bboxes, BboxCentroidOp {}), centroid_bounds, num_segments,
+                segment_offsets_gpu, BboxMergeOp {}, empty_bbox, build_scratch);
+            BuildAccelLbvhBatched(segments_gpu, num_segments, leaf_bboxes, segment_ids, centroid_bounds,
+                num_primitives, num_nodes, build_scratch);
+        }
+    }
+
+    // the optional passes and packing still run for each tree, trees of other builders are built here from
+    // the leaf bboxes calculated above
+    for (uint32_t i = 0; i < num_items; i++) {
+        const auto &item = items[i];
+        auto num_triangles = item.mesh.num_triangles;
+        if (num_triangles == 0) {
+            stats[i] = {};
+            continue;
+        }
+        stats[i] = item.options.builder == AccelBuilder::eLbvh ?
+            FinishAccel(item.nodes, item.bboxes, num_triangles, item.options, item.packed_nodes,
+                item.primitive_ids, build_scratch) :
+            BuildAccel(item.nodes, item.bboxes, item.merged_bbox, num_triangles, item.options, item.packed_nodes,
+                item.primitive_ids, &build_scratch);
+    }
+}
+
+size_t AccelSahCostScratchSize(uint32_t num_leaves) {
+    auto num_nodes = 2 * num_leaves - 1;
+    return CuScratch::PieceSize(sizeof(float) * num_nodes)
+        + ReduceScratchSize<float, const float *, thrust::plus<float>>(num_nodes);
+}
+
+float CalcAccelSahCost(const AccelNode *nodes, const Bbox *bboxes, uint32_t num_leaves, CuScratch *scratch) {
+    auto num_nodes = 2 * num_leaves - 1;
+    auto &cost_scratch = AccelScratchOrDefault(scratch);
+    CuScratch::Scope scope(cost_scratch);
+    auto costs = cost_scratch.Allocate<float>(num_nodes);
+    auto threads = BlockSizeOf<CalcNodesSahCost>();
+    CalcNodesSahCost<<<(num_nodes + threads - 1) / threads, threads>>>(nodes, bboxes, costs, num_nodes);
+    auto cost = Reduce(static_cast<const float *>(costs), num_nodes, thrust::plus<float> {}, 0.0f, cost_scratch);
+
+    Bbox root_bbox;
+    cudaMemcpy(&root_bbox, bboxes, sizeof(Bbox), cudaMemcpyDeviceToHost);
+    auto root_area = BboxHalfArea(root_bbox);
+    return root_area > 0.0f ? cost / root_area : 0.0f;
+}
+
+}
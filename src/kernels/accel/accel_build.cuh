@@ -1,9 +1,163 @@
-#pragma once
-
-#include "accel.cuh"
-
-namespace kernel {
-
-void BuildAccel(AccelNode *nodes, Bbox *bboxes, Bbox merged_bbox, uint32_t num_primitives);
-
-}
+#pragma once
+
+#include "accel.cuh"
+
+#include "cuda_helpers/scratch.hpp"
+
+namespace kernel {
+
+constexpr float kSahTraversalCost = 1.0f;
+constexpr float kSahIntersectionCost = 1.0f;
+
+enum struct AccelBuilder {
+    eLbvh,
+    eSah,
+    ePloc,
+    // binned SAH with spatial splits, only used by `BuildAccelSpatial` and same as `eSah` elsewhere
+    eSbvh,
+};
+
+struct AccelBuildOptions {
+    AccelBuilder builder = AccelBuilder::eLbvh;
+    uint32_t num_sah_bins = 16;
+    // how many neighbours on each side of a cluster in Morton order are searched by PLOC
+    uint32_t ploc_radius = 16;
+    AccelLayout layout = AccelLayout::eBinary;
+    // treelet restructuring passes run on the built binary tree, 0 to disable
+    uint32_t num_treelet_passes = 0;
+    // subtrees of up to this many primitives (at most `kAccelMaxLeafSize`) are collapsed into one leaf
+    // where it lowers the SAH cost, this needs `primitive_ids` to be given to the build, 1 to disable
+    uint32_t max_leaf_size = 1;
+    // a refit that raises the SAH cost of the tree above this many times its cost after the last build
+    // should be followed by a full rebuild
+    float max_refit_cost_ratio = 1.5f;
+    // spatial splits may reference primitives from several leaves,
+    // adding at most this fraction of the number of primitives as extra references
+    float max_spatial_split_growth = 0.5f;
+};
+
+// `initial_sah_cost` is only calculated when some optimization pass runs
+struct AccelBuildStats {
+    float initial_sah_cost = 0.0f;
+    float sah_cost = 0.0f;
+    // the built tree has `2 * num_leaves - 1` nodes
+    uint32_t num_leaves = 0;
+    // number of primitive ids referenced by leaves, more than the number of primitives with spatial splits
+    uint32_t num_references = 0;
+    // layout the tree is traversed with, see `PackAccel`
+    AccelLayout layout = AccelLayout::eBinary;
+};
+
+// quality measures of a built tree
+struct AccelAnalysis {
+    float sah_cost = 0.0f;
+    uint32_t max_depth = 0;
+    // over leaves
+    float average_depth = 0.0f;
+    // sum of the surface areas where the bboxes of siblings overlap, normalized by the root surface area
+    float sibling_overlap = 0.0f;
+    // number of leaves holding `i + 1` primitives at `i`
+    uint32_t leaf_size_histogram[kAccelMaxLeafSize] = {};
+    // leaves deep enough that reaching them may overflow the traversal stack of binary layouts
+    uint32_t num_deep_leaves = 0;
+    // bytes taken by nodes, bboxes, packed nodes and primitive ids
+    size_t memory_size = 0;
+};
+
+// size in bytes of the `packed_nodes` of a layout, 0 for `AccelLayout::eBinary`
+size_t AccelPackedNodesSize(AccelLayout layout, uint32_t num_primitives);
+
+// `nodes` and `bboxes` hold `2 * num_primitives - 1` elements, leaf bboxes are passed in at
+// [num_primitives - 1, 2 * num_primitives - 1) and node 0 is the root after building,
+// the binary tree is then packed into `packed_nodes` if `options.layout` asks for it,
+// leaves refer to `primitive_ids` of `num_primitives` elements if given or else to primitives directly,
+// when `primitive_ids` is given the nodes are also reordered depth-first so that leaves follow it in order,
+// temporary buffers are taken from `scratch`, or from scratch memory kept for all calls if it is not given
+AccelBuildStats BuildAccel(AccelNode *nodes, Bbox *bboxes, Bbox merged_bbox, uint32_t num_primitives,
+    const AccelBuildOptions &options = {}, void *packed_nodes = nullptr, uint32_t *primitive_ids = nullptr,
+    CuScratch *scratch = nullptr);
+
+// bytes of scratch memory a build with `options` over `num_primitives` primitives takes, reserving this much
+// before building lets it run without allocating
+size_t AccelScratchSize(const AccelBuildOptions &options, uint32_t num_primitives);
+
+// the number of primitive references a build with `options` may produce from `num_primitives` primitives
+uint32_t AccelMaxReferences(const AccelBuildOptions &options, uint32_t num_primitives);
+
+// same as `BuildAccel` but builds over the triangles given by `positions` and `indices` in host memory,
+// which may be split by `AccelBuilder::eSbvh`, so that `nodes` and `bboxes` hold `2 * max_references - 1`
+// elements and `primitive_ids` holds `max_references` elements, see `AccelMaxReferences`
+AccelBuildStats BuildAccelSpatial(AccelNode *nodes, Bbox *bboxes, const glm::vec3 *positions, const uint32_t *indices,
+    uint32_t num_triangles, const AccelBuildOptions &options, void *packed_nodes, uint32_t *primitive_ids,
+    CuScratch *scratch = nullptr);
+
+// one tree of `BuildAccelBatched`, `nodes`, `bboxes`, `packed_nodes` and `primitive_ids` are as given to `BuildAccel`
+struct AccelBatchItem {
+    // only indices and vertex positions of it are read, leaf bboxes are calculated from them
+    TriMesh mesh;
+    AccelNode *nodes;
+    Bbox *bboxes;
+    void *packed_nodes;
+    uint32_t *primitive_ids;
+    Bbox merged_bbox;
+    AccelBuildOptions options;
+};
+
+// builds trees over the triangles of several meshes as `BuildAccel` does for each of them, with leaf bboxes
+// calculated on the GPU and `AccelBuilder::eLbvh` trees built together by launches over all their triangles,
+// `stats` receives the stats of each tree
+void BuildAccelBatched(const AccelBatchItem *items, uint32_t num_items, AccelBuildStats *stats,
+    CuScratch *scratch = nullptr);
+
+// same as `AccelScratchSize` for `BuildAccelBatched`
+size_t AccelBatchScratchSize(const AccelBatchItem *items, uint32_t num_items);
+
+// converts a built binary tree of `num_leaves` leaves to `layout` and returns the layout it is packed to,
+// which is `AccelLayout::eStackless` instead of a wide or compact layout when the packed tree is too deep for the
+// traversal stack, its parent links fit in `packed_nodes` sized for any of those layouts
+AccelLayout PackAccel(const AccelNode *nodes, const Bbox *bboxes, uint32_t num_leaves, AccelLayout layout,
+    void *packed_nodes, CuScratch *scratch = nullptr);
+
+struct AccelRefitStats {
+    float sah_cost = 0.0f;
+    // layout the refitted tree is traversed with, which may differ from the one it was built with since wide nodes
+    // are chosen again from the new bboxes, see `PackAccel`
+    AccelLayout layout = AccelLayout::eBinary;
+};
+
+// recomputes the bboxes of a built tree bottom-up from `primitive_bboxes`, indexed by primitive id, keeping its
+// topology, and packs it again into `packed_nodes` with `layout` as `PackAccel` does, `parents` is scratch space
+// of `2 * num_leaves - 1` elements
+AccelRefitStats RefitAccel(AccelNode *nodes, Bbox *bboxes, uint32_t *parents, const Bbox *primitive_bboxes,
+    const uint32_t *primitive_ids, uint32_t num_leaves, AccelLayout layout, void *packed_nodes,
+    CuScratch *scratch = nullptr);
+
+// same as `AccelScratchSize` for `RefitAccel`
+size_t AccelRefitScratchSize(uint32_t num_leaves, AccelLayout layout);
+
+// same as `BuildAccel` but runs on the CPU with host memory
+AccelBuildStats BuildAccelHost(AccelNode *nodes, Bbox *bboxes, Bbox merged_bbox, uint32_t num_primitives,
+    const AccelBuildOptions &options = {}, void *packed_nodes = nullptr, uint32_t *primitive_ids = nullptr);
+
+AccelBuildStats BuildAccelSpatialHost(AccelNode *nodes, Bbox *bboxes, const glm::vec3 *positions,
+    const uint32_t *indices, uint32_t num_triangles, const AccelBuildOptions &options, void *packed_nodes,
+    uint32_t *primitive_ids);
+
+AccelLayout PackAccelHost(const AccelNode *nodes, const Bbox *bboxes, uint32_t num_leaves, AccelLayout layout,
+    void *packed_nodes);
+
+AccelRefitStats RefitAccelHost(AccelNode *nodes, Bbox *bboxes, const Bbox *primitive_bboxes, const uint32_t *primitive_ids,
+    uint32_t num_leaves, AccelLayout layout, void *packed_nodes);
+
+// analyzes a built tree of `num_leaves` leaves in host memory, `num_primitive_ids` is the number of primitive ids
+// it is built with, 0 if there are none
+AccelAnalysis AnalyzeAccelHost(const AccelNode *nodes, const Bbox *bboxes, uint32_t num_leaves,
+    uint32_t num_primitive_ids, AccelLayout layout);
+
+// SAH cost of a built binary tree, normalized by the root surface area
+float CalcAccelSahCost(const AccelNode *nodes, const Bbox *bboxes, uint32_t num_leaves, CuScratch *scratch = nullptr);
+
+// same as `CalcAccelSahCost` but with host memory
+float CalcAccelSahCostHost(const AccelNode *nodes, const Bbox *bboxes);
+
+}
@@ -0,0 +1,652 @@
+#pragma once
+
+#include <bit>
+#include <cfloat>
+
+#ifdef __CUDACC__
+#include <cub/device/device_radix_sort.cuh>
+#include <cub/device/device_reduce.cuh>
+#include <cub/device/device_scan.cuh>
+#include <cub/device/device_segmented_reduce.cuh>
+#endif
+
+#include "accel_build.cuh"
+
+namespace kernel {
+
+// bits per axis, 63 bits in total
+constexpr uint32_t kMortonCodeBits = 21;
+constexpr float kMortonCodeResolution = 1u << kMortonCodeBits;
+
+constexpr uint32_t kTreeletSize = 7;
+
+inline CU_DEVICE_HOST uint32_t Clz32(uint32_t x) {
+#ifdef __CUDA_ARCH__
+    return __clz(x);
+#else
+    return std::countl_zero(x);
+#endif
+}
+
+inline CU_DEVICE_HOST uint32_t Clz64(uint64_t x) {
+#ifdef __CUDA_ARCH__
+    return __clzll(x);
+#else
+    return std::countl_zero(x);
+#endif
+}
+
+inline CU_DEVICE_HOST uint64_t MortonCode3(uint32_t x) {
+    uint64_t v = x & 0x1fffff;
+    v = (v ^ (v << 32)) & 0x001f00000000ffffull;
+    v = (v ^ (v << 16)) & 0x001f0000ff0000ffull;
+    v = (v ^ (v << 8)) & 0x100f00f00f00f00full;
+    v = (v ^ (v << 4)) & 0x10c30c30c30c30c3ull;
+    v = (v ^ (v << 2)) & 0x1249249249249249ull;
+    return v;
+}
+
+inline CU_DEVICE_HOST glm::vec3 BboxCentroid(const Bbox &bbox) {
+    return (glm::vec3(bbox.pmin) + glm::vec3(bbox.pmax)) * 0.5f;
+}
+
+// `centroid_bounds` bounds the centroids rather than the primitives so that the whole grid is used
+inline CU_DEVICE_HOST uint64_t MortonCodeOf(const Bbox &bbox, const Bbox &centroid_bounds) {
+    auto cmin = glm::vec3(centroid_bounds.pmin);
+    auto extent = glm::vec3(centroid_bounds.pmax) - cmin;
+    auto p = (BboxCentroid(bbox) - cmin) / glm::max(extent, glm::vec3(FLT_MIN));
+
+    auto x = MortonCode3(fmin(fmax(p.x * kMortonCodeResolution, 0.0f), kMortonCodeResolution - 1));
+    auto y = MortonCode3(fmin(fmax(p.y * kMortonCodeResolution, 0.0f), kMortonCodeResolution - 1));
+    auto z = MortonCode3(fmin(fmax(p.z * kMortonCodeResolution, 0.0f), kMortonCodeResolution - 1));
+    return (x << 2) | (y << 1) | z;
+}
+
+struct BboxCentroidOp {
+    CU_DEVICE_HOST Bbox operator()(const Bbox &bbox) const {
+        auto centroid = glm::vec4(BboxCentroid(bbox), 1.0f);
+        return Bbox { centroid, centroid };
+    }
+};
+
+struct BboxMergeOp {
+    CU_DEVICE_HOST Bbox operator()(const Bbox &a, const Bbox &b) const {
+        return Bbox { glm::min(a.pmin, b.pmin), glm::max(a.pmax, b.pmax) };
+    }
+};
+
+// length of the common prefix of sorted keys `i` and `j`, -1 if `j` is out of range,
+// equal codes are told apart by their indices
+inline CU_DEVICE_HOST int Lcp(const uint64_t *codes, uint32_t num_primitives, uint32_t i, int64_t j) {
+    if (j < 0 || j >= num_primitives) {
+        return -1;
+    }
+    auto a = codes[i];
+    auto b = codes[j];
+    if (a == b) {
+        return 64 + Clz32(i ^ static_cast<uint32_t>(j));
+    }
+    return Clz64(a ^ b);
+}
+
+inline CU_DEVICE_HOST glm::uvec2 FindNodeRange(uint32_t index, const uint64_t *codes, uint32_t num_primitives) {
+    if (index == 0) {
+        return glm::uvec2(0, num_primitives - 1);
+    }
+
+    int64_t d = Lcp(codes, num_primitives, index, index + 1) > Lcp(codes, num_primitives, index, index - 1) ? 1 : -1;
+    auto min_lcp = Lcp(codes, num_primitives, index, index - d);
+    int64_t max_step = 2;
+    while (Lcp(codes, num_primitives, index, index + max_step * d) > min_lcp) {
+        max_step <<= 1;
+    }
+
+    int64_t l = 0;
+    for (auto step = max_step >> 1; step > 0; step >>= 1) {
+        if (Lcp(codes, num_primitives, index, index + (l + step) * d) > min_lcp) {
+            l += step;
+        }
+    }
+
+    uint32_t j = index + l * d;
+    return index <= j ? glm::uvec2(index, j) : glm::uvec2(j, index);
+}
+
+inline CU_DEVICE_HOST uint32_t FindNodeLeftChild(uint32_t index, glm::uvec2 range, const uint64_t *codes,
+    uint32_t num_primitives) {
+    auto node_lcp = Lcp(codes, num_primitives, range.x, range.y);
+
+    auto split = range.x;
+    auto step = range.y - range.x;
+    do {
+        step = (step + 1) >> 1;
+        auto new_split = split + step;
+        if (new_split < range.y && Lcp(codes, num_primitives, range.x, new_split) > node_lcp) {
+            split = new_split;
+        }
+    } while (step > 1);
+
+    return split;
+}
+
+inline CU_DEVICE_HOST float BboxHalfArea(const glm::vec3 &pmin, const glm::vec3 &pmax) {
+    auto d = glm::max(pmax - pmin, glm::vec3(0.0f));
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+inline CU_DEVICE_HOST float BboxHalfArea(const Bbox &bbox) {
+    return BboxHalfArea(glm::vec3(bbox.pmin), glm::vec3(bbox.pmax));
+}
+
+// reads what another thread may have just written, volatile loads skip the L1 cache, which is not coherent
+// across blocks and may still hold an old copy
+template <typename T>
+inline CU_DEVICE_HOST T LoadVolatile(const T &value) {
+    return *reinterpret_cast<const volatile T *>(&value);
+}
+
+inline CU_DEVICE_HOST Bbox LoadBboxVolatile(const Bbox &bbox) {
+    auto v = reinterpret_cast<const volatile float *>(&bbox);
+    return Bbox {
+        .pmin = glm::vec4(v[0], v[1], v[2], v[3]),
+        .pmax = glm::vec4(v[4], v[5], v[6], v[7]),
+    };
+}
+
+inline CU_DEVICE_HOST AccelNode LoadNodeVolatile(const AccelNode &node) {
+    auto v = reinterpret_cast<const volatile uint32_t *>(&node);
+    return AccelNode { v[0], v[1] };
+}
+
+inline CU_DEVICE_HOST uint32_t SahBinIndex(float centroid, float cmin, float cmax, uint32_t num_bins) {
+    if (!(cmax > cmin)) {
+        return 0;
+    }
+    auto bin = static_cast<uint32_t>((centroid - cmin) / (cmax - cmin) * num_bins);
+    return glm::min(bin, num_bins - 1);
+}
+
+// picks up to `width` descendants of binary node `root` as the children of one wide node
+// by repeatedly opening the internal child with the largest surface area
+inline CU_DEVICE_HOST uint32_t CollapseWideChildren(const AccelNode *nodes, const Bbox *bboxes, uint32_t root,
+    uint32_t width, uint32_t *children) {
+    children[0] = root;
+    uint32_t num_children = 1;
+    while (num_children < width) {
+        uint32_t best = ~0u;
+        float best_area = -1.0f;
+        for (uint32_t i = 0; i < num_children; i++) {
+            if (!nodes[children[i]].IsLeaf()) {
+                auto area = BboxHalfArea(bboxes[children[i]]);
+                if (area > best_area) {
+                    best_area = area;
+                    best = i;
+                }
+            }
+        }
+        if (best == ~0u) {
+            break;
+        }
+        auto u = children[best];
+        children[best] = nodes[u].lc_or_id;
+        children[num_children++] = nodes[u].rc;
+    }
+    return num_children;
+}
+
+// most children a node of `WideNode` holds
+template <typename WideNode>
+constexpr uint32_t kWideNodeWidth = sizeof(WideNode::children) / sizeof(uint32_t);
+
+// `alloc_node(binary_node)` returns the index of the wide node that binary internal node `binary_node` becomes
+template <uint32_t Width, typename AllocFunc>
+CU_DEVICE_HOST void FillWideNode(AccelWideNode<Width> &wide_node, const AccelNode *nodes, const Bbox *bboxes,
+    uint32_t root, AllocFunc &&alloc_node) {
+    uint32_t children[Width];
+    auto num_children = CollapseWideChildren(nodes, bboxes, root, Width, children);
+    for (uint32_t i = 0; i < Width; i++) {
+        if (i < num_children) {
+            const auto &bbox = bboxes[children[i]];
+            wide_node.pmin_x[i] = bbox.pmin.x;
+            wide_node.pmin_y[i] = bbox.pmin.y;
+            wide_node.pmin_z[i] = bbox.pmin.z;
+            wide_node.pmax_x[i] = bbox.pmax.x;
+            wide_node.pmax_y[i] = bbox.pmax.y;
+            wide_node.pmax_z[i] = bbox.pmax.z;
+            const auto &node = nodes[children[i]];
+            wide_node.children[i] =
+                node.IsLeaf() ? AccelPackedLeaf(node.lc_or_id, node.NumPrimitives()) : alloc_node(children[i]);
+        } else {
+            wide_node.pmin_x[i] = wide_node.pmin_y[i] = wide_node.pmin_z[i] = 0.0f;
+            wide_node.pmax_x[i] = wide_node.pmax_y[i] = wide_node.pmax_z[i] = 0.0f;
+            wide_node.children[i] = kAccelInvalidChild;
+        }
+    }
+}
+
+// the smallest power of 2 step, as a biased exponent, with which 255 steps from `origin` reach `pmax`
+inline CU_DEVICE_HOST uint8_t QuantizedNodeExponent(float origin, float pmax) {
+    auto step = glm::floatBitsToUint((pmax - origin) / 255.0f);
+    auto exponent = glm::clamp((step >> 23) + ((step & 0x7fffffu) != 0 ? 1u : 0u), 1u, 254u);
+    while (exponent < 254 && origin + 255.0f * glm::uintBitsToFloat(exponent << 23) < pmax) {
+        ++exponent;
+    }
+    return static_cast<uint8_t>(exponent);
+}
+
+// quantizes [pmin, pmax] on the grid of a node, outwards with the same arithmetic as the traversal decodes it
+inline CU_DEVICE_HOST void QuantizeInterval(float origin, float scale, float pmin, float pmax, uint8_t &qmin,
+    uint8_t &qmax) {
+    auto lo = static_cast<int>(glm::clamp(glm::floor((pmin - origin) / scale), 0.0f, 255.0f));
+    while (lo > 0 && origin + lo * scale > pmin) {
+        --lo;
+    }
+    auto hi = static_cast<int>(glm::clamp(glm::ceil((pmax - origin) / scale), 0.0f, 255.0f));
+    while (hi < 255 && origin + hi * scale < pmax) {
+        ++hi;
+    }
+    qmin = static_cast<uint8_t>(lo);
+    qmax = static_cast<uint8_t>(hi);
+}
+
+template <typename AllocFunc>
+CU_DEVICE_HOST void FillWideNode(AccelQuantizedNode &quantized_node, const AccelNode *nodes, const Bbox *bboxes,
+    uint32_t root, AllocFunc &&alloc_node) {
+    AccelWideNode<kAccelMaxWidth> wide_node;
+    FillWideNode(wide_node, nodes, bboxes, root, alloc_node);
+
+    glm::vec3 pmin(FLT_MAX);
+    glm::vec3 pmax(-FLT_MAX);
+    for (uint32_t i = 0; i < kAccelMaxWidth && wide_node.children[i] != kAccelInvalidChild; i++) {
+        pmin = glm::min(pmin, glm::vec3(wide_node.pmin_x[i], wide_node.pmin_y[i], wide_node.pmin_z[i]));
+        pmax = glm::max(pmax, glm::vec3(wide_node.pmax_x[i], wide_node.pmax_y[i], wide_node.pmax_z[i]));
+    }
+    quantized_node.origin = pmin;
+    for (uint32_t axis = 0; axis < 3; axis++) {
+        quantized_node.exponents[axis] = QuantizedNodeExponent(pmin[axis], pmax[axis]);
+    }
+    quantized_node.padding = 0;
+    auto scale = quantized_node.Scale();
+    for (uint32_t i = 0; i < kAccelMaxWidth; i++) {
+        quantized_node.children[i] = wide_node.children[i];
+        if (wide_node.children[i] == kAccelInvalidChild) {
+            quantized_node.qmin_x[i] = quantized_node.qmin_y[i] = quantized_node.qmin_z[i] = 0;
+            quantized_node.qmax_x[i] = quantized_node.qmax_y[i] = quantized_node.qmax_z[i] = 0;
+            continue;
+        }
+        QuantizeInterval(pmin.x, scale.x, wide_node.pmin_x[i], wide_node.pmax_x[i], quantized_node.qmin_x[i],
+            quantized_node.qmax_x[i]);
+        QuantizeInterval(pmin.y, scale.y, wide_node.pmin_y[i], wide_node.pmax_y[i], quantized_node.qmin_y[i],
+            quantized_node.qmax_y[i]);
+        QuantizeInterval(pmin.z, scale.z, wide_node.pmin_z[i], wide_node.pmax_z[i], quantized_node.qmin_z[i],
+            quantized_node.qmax_z[i]);
+    }
+}
+
+// the cluster within `radius` in Morton order whose merged bbox is the smallest, ties go to the lower index
+// so that the globally closest pair always finds each other
+inline CU_DEVICE_HOST uint32_t FindNearestCluster(const uint32_t *clusters, const Bbox *bboxes, uint32_t index,
+    uint32_t num_clusters, uint32_t radius) {
+    const auto &bbox = bboxes[clusters[index]];
+    auto begin = index > radius ? index - radius : 0;
+    auto end = glm::min(index + radius + 1, num_clusters);
+    float best_area = FLT_MAX;
+    uint32_t best = index;
+    for (auto i = begin; i < end; i++) {
+        if (i == index) {
+            continue;
+        }
+        const auto &other = bboxes[clusters[i]];
+        auto area = BboxHalfArea(glm::min(glm::vec3(bbox.pmin), glm::vec3(other.pmin)),
+            glm::max(glm::vec3(bbox.pmax), glm::vec3(other.pmax)));
+        if (area < best_area) {
+            best_area = area;
+            best = i;
+        }
+    }
+    return best;
+}
+
+inline CU_DEVICE_HOST float SahNodeCost(const AccelNode &node, const Bbox &bbox) {
+    auto cost = node.IsLeaf() ? kSahIntersectionCost * node.NumPrimitives() : kSahTraversalCost;
+    return cost * BboxHalfArea(bbox);
+}
+
+inline CU_DEVICE_HOST uint32_t PackedChildOf(const AccelNode *nodes, uint32_t child) {
+    return nodes[child].IsLeaf() ? AccelPackedLeaf(nodes[child].lc_or_id, nodes[child].NumPrimitives()) : child;
+}
+
+// compact node `index` mirrors binary internal node `index`, a single leaf root gets only a left child
+inline CU_DEVICE_HOST void FillCompactNode(AccelCompactNode &compact_node, const AccelNode *nodes, const Bbox *bboxes,
+    uint32_t index) {
+    if (nodes[index].IsLeaf()) {
+        compact_node.lc = PackedChildOf(nodes, index);
+        compact_node.lc_pmin = bboxes[index].pmin;
+        compact_node.lc_pmax = bboxes[index].pmax;
+        compact_node.rc = kAccelInvalidChild;
+        compact_node.rc_pmin = compact_node.rc_pmax = glm::vec3(0.0f);
+    } else {
+        auto lc = nodes[index].lc_or_id;
+        auto rc = nodes[index].rc;
+        compact_node.lc = PackedChildOf(nodes, lc);
+        compact_node.lc_pmin = bboxes[lc].pmin;
+        compact_node.lc_pmax = bboxes[lc].pmax;
+        compact_node.rc = PackedChildOf(nodes, rc);
+        compact_node.rc_pmin = bboxes[rc].pmin;
+        compact_node.rc_pmax = bboxes[rc].pmax;
+    }
+    compact_node.padding0 = compact_node.padding1 = 0;
+}
+
+// merged bbox of the primitives of leaf `node`
+inline CU_DEVICE_HOST Bbox RefitLeafBbox(const AccelNode &node, const Bbox *primitive_bboxes,
+    const uint32_t *primitive_ids) {
+    Bbox bbox {
+        .pmin = glm::vec4(FLT_MAX, FLT_MAX, FLT_MAX, 1.0f),
+        .pmax = glm::vec4(-FLT_MAX, -FLT_MAX, -FLT_MAX, 1.0f),
+    };
+    for (uint32_t i = node.lc_or_id; i < node.lc_or_id + node.NumPrimitives(); i++) {
+        const auto &primitive_bbox = primitive_bboxes[primitive_ids ? primitive_ids[i] : i];
+        bbox.pmin = glm::min(bbox.pmin, primitive_bbox.pmin);
+        bbox.pmax = glm::max(bbox.pmax, primitive_bbox.pmax);
+    }
+    return bbox;
+}
+
+// the cheaper unnormalized SAH cost of an internal node over its children and of a leaf holding its whole subtree,
+// `collapse` is set if the leaf is chosen
+inline CU_DEVICE_HOST float CollapsedNodeCost(const Bbox &bbox, uint32_t num_primitives, float children_cost,
+    uint32_t max_leaf_size, bool &collapse) {
+    auto area = BboxHalfArea(bbox);
+    auto internal_cost = kSahTraversalCost * area + children_cost;
+    auto leaf_cost = kSahIntersectionCost * area * num_primitives;
+    collapse = num_primitives <= max_leaf_size && leaf_cost <= internal_cost;
+    return collapse ? leaf_cost : internal_cost;
+}
+
+// restructures the treelet of at most `kTreeletSize` leaves below internal node `root` to minimize its SAH cost,
+// `costs` holds the unnormalized SAH cost of the subtree of each node and must be valid below `root`
+inline CU_DEVICE_HOST void RestructureTreelet(AccelNode *nodes, Bbox *bboxes, uint32_t *parents, float *costs,
+    uint32_t root) {
+    uint32_t leaves[kTreeletSize];
+    uint32_t internals[kTreeletSize - 1];
+    leaves[0] = nodes[root].lc_or_id;
+    leaves[1] = nodes[root].rc;
+    internals[0] = root;
+    uint32_t num_leaves = 2;
+    while (num_leaves < kTreeletSize) {
+        uint32_t best = ~0u;
+        float best_area = -1.0f;
+        for (uint32_t i = 0; i < num_leaves; i++) {
+            if (!LoadNodeVolatile(nodes[leaves[i]]).IsLeaf()) {
+                auto area = BboxHalfArea(LoadBboxVolatile(bboxes[leaves[i]]));
+                if (area > best_area) {
+                    best_area = area;
+                    best = i;
+                }
+            }
+        }
+        if (best == ~0u) {
+            break;
+        }
+        auto u = leaves[best];
+        auto node = LoadNodeVolatile(nodes[u]);
+        internals[num_leaves - 1] = u;
+        leaves[best] = node.lc_or_id;
+        leaves[num_leaves++] = node.rc;
+    }
+    if (num_leaves < 3) {
+        return;
+    }
+
+    // treelet leaves may have been written by other threads, they are read once here
+    Bbox leaf_bboxes[kTreeletSize];
+    for (uint32_t i = 0; i < num_leaves; i++) {
+        leaf_bboxes[i] = LoadBboxVolatile(bboxes[leaves[i]]);
+    }
+
+    // optimal partition of every subset of the treelet leaves, subsets only depend on smaller ones
+    float subset_areas[1u << kTreeletSize];
+    float subset_costs[1u << kTreeletSize];
+    uint8_t subset_partitions[1u << kTreeletSize];
+    uint32_t num_subsets = 1u << num_leaves;
+    for (uint32_t s = 1; s < num_subsets; s++) {
+        glm::vec3 pmin(FLT_MAX), pmax(-FLT_MAX);
+        for (uint32_t i = 0; i < num_leaves; i++) {
+            if (s & (1u << i)) {
+                pmin = glm::min(pmin, glm::vec3(leaf_bboxes[i].pmin));
+                pmax = glm::max(pmax, glm::vec3(leaf_bboxes[i].pmax));
+            }
+        }
+        subset_areas[s] = BboxHalfArea(pmin, pmax);
+    }
+    for (uint32_t i = 0; i < num_leaves; i++) {
+        subset_costs[1u << i] = LoadVolatile(costs[leaves[i]]);
+    }
+    for (uint32_t s = 1; s < num_subsets; s++) {
+        if ((s & (s - 1)) == 0) {
+            continue;
+        }
+        auto lowest = s & (~s + 1);
+        float best_cost = FLT_MAX;
+        uint32_t best_partition = 0;
+        for (uint32_t p = (s - 1) & s; p > 0; p = (p - 1) & s) {
+            if ((p & lowest) == 0) {
+                continue;
+            }
+            auto cost = subset_costs[p] + subset_costs[s ^ p];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_partition = p;
+            }
+        }
+        subset_costs[s] = kSahTraversalCost * subset_areas[s] + best_cost;
+        subset_partitions[s] = best_partition;
+    }
+
+    auto all = num_subsets - 1;
+    if (!(subset_costs[all] < costs[root])) {
+        return;
+    }
+
+    uint32_t stack_subsets[kTreeletSize - 1];
+    uint32_t stack_nodes[kTreeletSize - 1];
+    stack_subsets[0] = all;
+    stack_nodes[0] = root;
+    uint32_t sp = 1;
+    uint32_t num_used_internals = 1;
+    while (sp > 0) {
+        --sp;
+        auto s = stack_subsets[sp];
+        auto u = stack_nodes[sp];
+        uint32_t child_subsets[2] = { subset_partitions[s], s ^ subset_partitions[s] };
+        uint32_t children[2];
+        for (uint32_t c = 0; c < 2; c++) {
+            auto cs = child_subsets[c];
+            if ((cs & (cs - 1)) == 0) {
+                uint32_t i = 0;
+                while ((cs >> i) != 1) {
+                    ++i;
+                }
+                children[c] = leaves[i];
+            } else {
+                children[c] = internals[num_used_internals++];
+                stack_subsets[sp] = cs;
+                stack_nodes[sp] = children[c];
+                ++sp;
+            }
+            parents[children[c]] = u;
+        }
+        nodes[u] = AccelNode { children[0], children[1] };
+
+        glm::vec3 pmin(FLT_MAX), pmax(-FLT_MAX);
+        for (uint32_t i = 0; i < num_leaves; i++) {
+            if (s & (1u << i)) {
+                pmin = glm::min(pmin, glm::vec3(leaf_bboxes[i].pmin));
+                pmax = glm::max(pmax, glm::vec3(leaf_bboxes[i].pmax));
+            }
+        }
+        bboxes[u].pmin = glm::vec4(pmin, 1.0f);
+        bboxes[u].pmax = glm::vec4(pmax, 1.0f);
+        costs[u] = subset_costs[s];
+    }
+}
+
+#ifdef __CUDACC__
+
+inline CU_DEVICE float atomicMinFloat(float *addr, float value) {
+    return !signbit(value) ? __int_as_float(atomicMin(reinterpret_cast<int *>(addr), __float_as_int(value))) :
+        __uint_as_float(atomicMax(reinterpret_cast<uint32_t *>(addr), __float_as_uint(value)));
+}
+
+inline CU_DEVICE float atomicMaxFloat(float *addr, float value) {
+    return !signbit(value) ? __int_as_float(atomicMax(reinterpret_cast<int *>(addr), __float_as_int(value))) :
+        __uint_as_float(atomicMin(reinterpret_cast<uint32_t *>(addr), __float_as_uint(value)));
+}
+
+inline CU_DEVICE void atomicMergeBbox(Bbox &bbox, const glm::vec3 &pmin, const glm::vec3 &pmax) {
+    atomicMinFloat(&bbox.pmin.x, pmin.x);
+    atomicMinFloat(&bbox.pmin.y, pmin.y);
+    atomicMinFloat(&bbox.pmin.z, pmin.z);
+    atomicMaxFloat(&bbox.pmax.x, pmax.x);
+    atomicMaxFloat(&bbox.pmax.y, pmax.y);
+    atomicMaxFloat(&bbox.pmax.z, pmax.z);
+}
+
+// device-wide algorithms of cub taking their temporary storage from scratch memory, the size of which is queried
+// from cub, so that each `...ScratchSize` below is exactly what its algorithm allocates
+
+template <typename Key, typename Value>
+size_t SortPairsScratchSize(uint32_t num_items) {
+    cub::DoubleBuffer<Key> keys;
+    cub::DoubleBuffer<Value> values;
+    size_t temp_size = 0;
+    cub::DeviceRadixSort::SortPairs(nullptr, temp_size, keys, values, num_items);
+    return CuScratch::PieceSize(sizeof(Key) * num_items) + CuScratch::PieceSize(sizeof(Value) * num_items)
+        + CuScratch::PieceSize(temp_size);
+}
+
+// sorts `values` by `keys` in place, stably
+template <typename Key, typename Value>
+void SortPairs(Key *keys, Value *values, uint32_t num_items, CuScratch &scratch) {
+    CuScratch::Scope scope(scratch);
+    cub::DoubleBuffer<Key> keys_buffer(keys, scratch.Allocate<Key>(num_items));
+    cub::DoubleBuffer<Value> values_buffer(values, scratch.Allocate<Value>(num_items));
+    size_t temp_size = 0;
+    cub::DeviceRadixSort::SortPairs(nullptr, temp_size, keys_buffer, values_buffer, num_items);
+    auto temp = scratch.Allocate(temp_size);
+    cub::DeviceRadixSort::SortPairs(temp, temp_size, keys_buffer, values_buffer, num_items);
+    if (keys_buffer.Current() != keys) {
+        cudaMemcpy(keys, keys_buffer.Current(), sizeof(Key) * num_items, cudaMemcpyDeviceToDevice);
+    }
+    if (values_buffer.Current() != values) {
+        cudaMemcpy(values, values_buffer.Current(), sizeof(Value) * num_items, cudaMemcpyDeviceToDevice);
+    }
+}
+
+template <typename T>
+size_t ExclusiveSumScratchSize(uint32_t num_items) {
+    size_t temp_size = 0;
+    cub::DeviceScan::ExclusiveSum(nullptr, temp_size, static_cast<const T *>(nullptr), static_cast<T *>(nullptr),
+        num_items);
+    return CuScratch::PieceSize(temp_size);
+}
+
+template <typename T>
+void ExclusiveSum(const T *input, T *output, uint32_t num_items, CuScratch &scratch) {
+    CuScratch::Scope scope(scratch);
+    size_t temp_size = 0;
+    cub::DeviceScan::ExclusiveSum(nullptr, temp_size, input, output, num_items);
+    auto temp = scratch.Allocate(temp_size);
+    cub::DeviceScan::ExclusiveSum(temp, temp_size, input, output, num_items);
+}
+
+template <typename T, typename Input, typename Op>
+size_t ReduceScratchSize(uint32_t num_items) {
+    size_t temp_size = 0;
+    cub::DeviceReduce::Reduce(nullptr, temp_size, Input {}, static_cast<T *>(nullptr), num_items, Op {}, T {});
+    return CuScratch::PieceSize(sizeof(T)) + CuScratch::PieceSize(temp_size);
+}
+
+// reduces `num_items` elements from `input` on the GPU and returns the result to the host
+template <typename T, typename Input, typename Op>
+T Reduce(Input input, uint32_t num_items, Op op, T init, CuScratch &scratch) {
+    CuScratch::Scope scope(scratch);
+    auto result_gpu = scratch.Allocate<T>(1);
+    size_t temp_size = 0;
+    cub::DeviceReduce::Reduce(nullptr, temp_size, input, result_gpu, num_items, op, init);
+    auto temp = scratch.Allocate(temp_size);
+    cub::DeviceReduce::Reduce(temp, temp_size, input, result_gpu, num_items, op, init);
+    T result;
+    cudaMemcpy(&result, result_gpu, sizeof(T), cudaMemcpyDeviceToHost);
+    return result;
+}
+
+template <typename T, typename Input, typename Op>
+size_t SegmentedReduceScratchSize(uint32_t num_segments) {
+    size_t temp_size = 0;
+    cub::DeviceSegmentedReduce::Reduce(nullptr, temp_size, Input {}, static_cast<T *>(nullptr), num_segments,
+        static_cast<const uint32_t *>(nullptr), static_cast<const uint32_t *>(nullptr), Op {}, T {});
+    return CuScratch::PieceSize(temp_size);
+}
+
+// reduces each segment [offsets[i], offsets[i + 1]) of `input` on the GPU into `output[i]`
+template <typename T, typename Input, typename Op>
+void SegmentedReduce(Input input, T *output, uint32_t num_segments, const uint32_t *offsets, Op op, T init,
+    CuScratch &scratch) {
+    CuScratch::Scope scope(scratch);
+    size_t temp_size = 0;
+    cub::DeviceSegmentedReduce::Reduce(nullptr, temp_size, input, output, num_segments, offsets, offsets + 1, op,
+        init);
+    auto temp = scratch.Allocate(temp_size);
+    cub::DeviceSegmentedReduce::Reduce(temp, temp_size, input, output, num_segments, offsets, offsets + 1, op,
+        init);
+}
+
+#endif
+
+// the scratch memory given to a public build function, or one kept for all calls not given any
+CuScratch &AccelScratchOrDefault(CuScratch *scratch);
+
+// bytes of scratch memory each of the functions below needs at most, the builds allocate nothing else on the GPU
+size_t SortLeavesScratchSize(uint32_t num_primitives);
+size_t UpdateInternalNodesBboxScratchSize(uint32_t num_primitives);
+size_t AccelTreeletScratchSize(uint32_t num_primitives);
+size_t AccelCollapseScratchSize(uint32_t num_primitives);
+size_t AccelSahScratchSize(uint32_t num_primitives, const AccelBuildOptions &options);
+size_t AccelPlocScratchSize(uint32_t num_primitives);
+size_t AccelPackScratchSize(uint32_t num_leaves, AccelLayout layout);
+size_t AccelSahCostScratchSize(uint32_t num_leaves);
+
+// writes the leaves to [num_primitives - 1, 2 * num_primitives - 1) in Morton order along with the sorted codes
+void SortLeavesByMortonCode(AccelNode *nodes, Bbox *bboxes, uint64_t *morton_codes, uint32_t num_primitives,
+    CuScratch &scratch);
+
+void CalcAccelParents(const AccelNode *nodes, uint32_t *parents, uint32_t num_primitives);
+
+// fills bboxes of internal nodes [0, num_primitives - 1) from the leaves upwards
+void UpdateInternalNodesBbox(const AccelNode *nodes, const uint32_t *parents, Bbox *bboxes, uint32_t num_primitives,
+    CuScratch &scratch);
+
+// runs `num_passes` bottom-up treelet restructuring passes
+void OptimizeAccelTreelets(AccelNode *nodes, Bbox *bboxes, uint32_t num_primitives, uint32_t num_passes,
+    CuScratch &scratch);
+
+// collapses subtrees of at most `max_leaf_size` primitives into single leaves where it lowers the SAH cost,
+// the tree is rewritten with the same layout over the returned number of leaves, internal nodes in preorder
+// and leaves in depth-first order so that each leaf refers to a contiguous range of `primitive_ids`
+uint32_t CollapseAccelLeaves(AccelNode *nodes, Bbox *bboxes, uint32_t *primitive_ids, uint32_t num_primitives,
+    uint32_t max_leaf_size, CuScratch &scratch);
+
+void BuildAccelSah(AccelNode *nodes, Bbox *bboxes, uint32_t num_primitives,
+    const AccelBuildOptions &options, CuScratch &scratch);
+
+void BuildAccelPloc(AccelNode *nodes, Bbox *bboxes, uint32_t num_primitives, const AccelBuildOptions &options,
+    CuScratch &scratch);
+
+// builds the binary tree of `AccelBuilder::eSbvh` on the CPU with host memory, returns its number of leaves,
+// each of which refers to one triangle with its bbox clipped to the leaf
+uint32_t BuildAccelSbvhHost(AccelNode *nodes, Bbox *bboxes, const glm::vec3 *positions, const uint32_t *indices,
+    uint32_t num_triangles, const AccelBuildOptions &options);
+
+}
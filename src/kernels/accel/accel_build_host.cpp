@@ -0,0 +1,841 @@
+#include "accel_build_common.cuh"
+
+#include <algorithm>
+#include <cfloat>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+namespace kernel {
+
+namespace {
+
+void CalcInternalNodesBboxHost(const AccelNode *nodes, Bbox *bboxes) {
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> stack { 0 };
+    while (!stack.empty()) {
+        auto u = stack.back();
+        stack.pop_back();
+        order.push_back(u);
+        if (!nodes[u].IsLeaf()) {
+            stack.push_back(nodes[u].lc_or_id);
+            stack.push_back(nodes[u].rc);
+        }
+    }
+
+    for (auto it = order.rbegin(); it != order.rend(); it++) {
+        const auto &node = nodes[*it];
+        if (!node.IsLeaf()) {
+            bboxes[*it].pmin = glm::min(bboxes[node.lc_or_id].pmin, bboxes[node.rc].pmin);
+            bboxes[*it].pmax = glm::max(bboxes[node.lc_or_id].pmax, bboxes[node.rc].pmax);
+        }
+    }
+}
+
+std::vector<uint64_t> SortLeavesByMortonCodeHost(AccelNode *nodes, Bbox *bboxes, uint32_t num_primitives) {
+    auto num_internal_nodes = num_primitives - 1;
+    auto bboxes_leaf = bboxes + num_internal_nodes;
+
+    Bbox centroid_bounds {
+        .pmin = glm::vec4(FLT_MAX, FLT_MAX, FLT_MAX, 1.0f),
+        .pmax = glm::vec4(-FLT_MAX, -FLT_MAX, -FLT_MAX, 1.0f),
+    };
+    for (uint32_t i = 0; i < num_primitives; i++) {
+        centroid_bounds = BboxMergeOp {}(centroid_bounds, BboxCentroidOp {}(bboxes_leaf[i]));
+    }
+
+    std::vector<std::pair<uint64_t, uint32_t>> keys(num_primitives);
+    for (uint32_t i = 0; i < num_primitives; i++) {
+        keys[i] = { MortonCodeOf(bboxes_leaf[i], centroid_bounds), i };
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<Bbox> prim_bboxes(bboxes_leaf, bboxes_leaf + num_primitives);
+    std::vector<uint64_t> morton_codes(num_primitives);
+    for (uint32_t i = 0; i < num_primitives; i++) {
+        auto [code, prim_id] = keys[i];
+        morton_codes[i] = code;
+        nodes[num_internal_nodes + i] = AccelLeafNode(prim_id, 1);
+        bboxes_leaf[i] = prim_bboxes[prim_id];
+    }
+    return morton_codes;
+}
+
+void BuildAccelLbvhHost(AccelNode *nodes, Bbox *bboxes, uint32_t num_primitives) {
+    auto num_internal_nodes = num_primitives - 1;
+    auto morton_codes = SortLeavesByMortonCodeHost(nodes, bboxes, num_primitives);
+
+    for (uint32_t i = 0; i < num_internal_nodes; i++) {
+        auto range = FindNodeRange(i, morton_codes.data(), num_primitives);
+        auto lc = FindNodeLeftChild(i, range, morton_codes.data(), num_primitives);
+        auto rc = lc + 1;
+        if (lc == range.x) {
+            lc += num_internal_nodes;
+        }
+        if (rc == range.y) {
+            rc += num_internal_nodes;
+        }
+        nodes[i] = AccelNode { lc, rc };
+    }
+
+    CalcInternalNodesBboxHost(nodes, bboxes);
+}
+
+void BuildAccelSahHost(AccelNode *nodes, Bbox *bboxes, uint32_t num_primitives, const AccelBuildOptions &options) {
+    auto num_internal_nodes = num_primitives - 1;
+    auto bboxes_leaf = bboxes + num_internal_nodes;
+    auto num_bins = glm::max(options.num_sah_bins, 2u);
+
+    std::vector<Bbox> prim_bboxes(bboxes_leaf, bboxes_leaf + num_primitives);
+    std::vector<uint32_t> prim_ids(num_primitives);
+    std::iota(prim_ids.begin(), prim_ids.end(), 0);
+
+    struct Task {
+        uint32_t node;
+        uint32_t begin;
+        uint32_t end;
+    };
+    std::vector<Task> tasks;
+    if (num_primitives > 1) {
+        tasks.push_back(Task { 0, 0, num_primitives });
+    }
+    uint32_t num_nodes = 1;
+
+    struct Bin {
+        glm::vec3 pmin;
+        glm::vec3 pmax;
+        uint32_t count;
+    };
+    std::vector<Bin> bins(3 * num_bins);
+
+    while (!tasks.empty()) {
+        auto task = tasks.back();
+        tasks.pop_back();
+
+        glm::vec3 cmin(FLT_MAX), cmax(-FLT_MAX);
+        for (auto i = task.begin; i < task.end; i++) {
+            auto centroid = BboxCentroid(prim_bboxes[prim_ids[i]]);
+            cmin = glm::min(cmin, centroid);
+            cmax = glm::max(cmax, centroid);
+        }
+
+        std::fill(bins.begin(), bins.end(), Bin { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX), 0 });
+        for (auto i = task.begin; i < task.end; i++) {
+            const auto &bbox = prim_bboxes[prim_ids[i]];
+            auto centroid = BboxCentroid(bbox);
+            for (uint32_t axis = 0; axis < 3; axis++) {
+                auto &bin = bins[axis * num_bins + SahBinIndex(centroid[axis], cmin[axis], cmax[axis], num_bins)];
+                bin.pmin = glm::min(bin.pmin, glm::vec3(bbox.pmin));
+                bin.pmax = glm::max(bin.pmax, glm::vec3(bbox.pmax));
+                ++bin.count;
+            }
+        }
+
+        float best_cost = FLT_MAX;
+        uint32_t best_axis = 3;
+        uint32_t best_bin = 0;
+        uint32_t num_left = (task.end - task.begin) / 2;
+        for (uint32_t axis = 0; axis < 3; axis++) {
+            auto axis_bins = bins.data() + axis * num_bins;
+            for (uint32_t split = 1; split < num_bins; split++) {
+                glm::vec3 l_pmin(FLT_MAX), l_pmax(-FLT_MAX), r_pmin(FLT_MAX), r_pmax(-FLT_MAX);
+                uint32_t l_count = 0, r_count = 0;
+                for (uint32_t i = 0; i < num_bins; i++) {
+                    if (axis_bins[i].count == 0) {
+                        continue;
+                    }
+                    if (i < split) {
+                        l_pmin = glm::min(l_pmin, axis_bins[i].pmin);
+                        l_pmax = glm::max(l_pmax, axis_bins[i].pmax);
+                        l_count += axis_bins[i].count;
+                    } else {
+                        r_pmin = glm::min(r_pmin, axis_bins[i].pmin);
+                        r_pmax = glm::max(r_pmax, axis_bins[i].pmax);
+                        r_count += axis_bins[i].count;
+                    }
+                }
+                if (l_count == 0 || r_count == 0) {
+                    continue;
+                }
+                auto cost = BboxHalfArea(l_pmin, l_pmax) * l_count + BboxHalfArea(r_pmin, r_pmax) * r_count;
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_bin = split;
+                    num_left = l_count;
+                }
+            }
+        }
+
+        if (best_axis < 3) {
+            std::stable_partition(prim_ids.begin() + task.begin, prim_ids.begin() + task.end, [&](uint32_t id) {
+                auto centroid = BboxCentroid(prim_bboxes[id]);
+                return SahBinIndex(centroid[best_axis], cmin[best_axis], cmax[best_axis], num_bins) < best_bin;
+            });
+        }
+
+        Task child_tasks[2] = {
+            { 0, task.begin, task.begin + num_left },
+            { 0, task.begin + num_left, task.end },
+        };
+        uint32_t children[2];
+        for (uint32_t i = 0; i < 2; i++) {
+            if (child_tasks[i].end - child_tasks[i].begin == 1) {
+                children[i] = num_internal_nodes + child_tasks[i].begin;
+            } else {
+                children[i] = num_nodes++;
+                child_tasks[i].node = children[i];
+                tasks.push_back(child_tasks[i]);
+            }
+        }
+        nodes[task.node] = AccelNode { children[0], children[1] };
+    }
+
+    for (uint32_t i = 0; i < num_primitives; i++) {
+        nodes[num_internal_nodes + i] = AccelLeafNode(prim_ids[i], 1);
+        bboxes_leaf[i] = prim_bboxes[prim_ids[i]];
+    }
+
+    CalcInternalNodesBboxHost(nodes, bboxes);
+}
+
+void BuildAccelPlocHost(AccelNode *nodes, Bbox *bboxes, uint32_t num_primitives, const AccelBuildOptions &options) {
+    auto radius = glm::max(options.ploc_radius, 1u);
+    SortLeavesByMortonCodeHost(nodes, bboxes, num_primitives);
+
+    std::vector<uint32_t> clusters(num_primitives);
+    std::iota(clusters.begin(), clusters.end(), num_primitives - 1);
+    std::vector<uint32_t> neighbours(num_primitives);
+    std::vector<uint32_t> next_clusters;
+    uint32_t next_node = num_primitives - 1;
+    while (clusters.size() > 1) {
+        uint32_t num_clusters = clusters.size();
+        for (uint32_t i = 0; i < num_clusters; i++) {
+            neighbours[i] = FindNearestCluster(clusters.data(), bboxes, i, num_clusters, radius);
+        }
+
+        uint32_t num_merges = 0;
+        for (uint32_t i = 0; i < num_clusters; i++) {
+            num_merges += neighbours[neighbours[i]] == i && i < neighbours[i] ? 1 : 0;
+        }
+
+        next_clusters.clear();
+        uint32_t node = next_node;
+        for (uint32_t i = 0; i < num_clusters; i++) {
+            auto neighbour = neighbours[i];
+            auto mutual = neighbours[neighbour] == i;
+            if (mutual && i > neighbour) {
+                continue;
+            }
+            auto cluster = clusters[i];
+            if (mutual) {
+                auto other = clusters[neighbour];
+                --node;
+                nodes[node] = AccelNode { cluster, other };
+                bboxes[node].pmin = glm::min(bboxes[cluster].pmin, bboxes[other].pmin);
+                bboxes[node].pmax = glm::max(bboxes[cluster].pmax, bboxes[other].pmax);
+                cluster = node;
+            }
+            next_clusters.push_back(cluster);
+        }
+        next_node -= num_merges;
+        std::swap(clusters, next_clusters);
+    }
+}
+
+void OptimizeAccelTreeletsHost(AccelNode *nodes, Bbox *bboxes, uint32_t num_primitives, uint32_t num_passes) {
+    if (num_primitives < 3) {
+        return;
+    }
+
+    auto num_nodes = 2 * num_primitives - 1;
+    std::vector<uint32_t> parents(num_nodes);
+    std::vector<float> costs(num_nodes);
+    std::vector<uint32_t> num_leaves(num_nodes);
+    for (uint32_t pass = 0; pass < num_passes; pass++) {
+        std::vector<uint32_t> order;
+        std::vector<uint32_t> stack { 0 };
+        while (!stack.empty()) {
+            auto u = stack.back();
+            stack.pop_back();
+            order.push_back(u);
+            if (!nodes[u].IsLeaf()) {
+                parents[nodes[u].lc_or_id] = u;
+                parents[nodes[u].rc] = u;
+                stack.push_back(nodes[u].lc_or_id);
+                stack.push_back(nodes[u].rc);
+            }
+        }
+
+        for (auto it = order.rbegin(); it != order.rend(); it++) {
+            auto u = *it;
+            if (nodes[u].IsLeaf()) {
+                costs[u] = SahNodeCost(nodes[u], bboxes[u]);
+                num_leaves[u] = 1;
+            } else {
+                auto lc = nodes[u].lc_or_id;
+                auto rc = nodes[u].rc;
+                num_leaves[u] = num_leaves[lc] + num_leaves[rc];
+                costs[u] = kSahTraversalCost * BboxHalfArea(bboxes[u]) + costs[lc] + costs[rc];
+                if (num_leaves[u] >= kTreeletSize) {
+                    RestructureTreelet(nodes, bboxes, parents.data(), costs.data(), u);
+                }
+            }
+        }
+    }
+}
+
+uint32_t CollapseAccelLeavesHost(AccelNode *nodes, Bbox *bboxes, uint32_t *primitive_ids, uint32_t num_primitives,
+    uint32_t max_leaf_size) {
+    auto num_nodes = 2 * num_primitives - 1;
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> stack { 0 };
+    while (!stack.empty()) {
+        auto u = stack.back();
+        stack.pop_back();
+        order.push_back(u);
+        if (!nodes[u].IsLeaf()) {
+            stack.push_back(nodes[u].rc);
+            stack.push_back(nodes[u].lc_or_id);
+        }
+    }
+
+    std::vector<float> costs(num_nodes);
+    std::vector<uint32_t> num_node_primitives(num_nodes);
+    std::vector<uint8_t> collapsed(num_nodes);
+    for (auto it = order.rbegin(); it != order.rend(); it++) {
+        auto u = *it;
+        if (nodes[u].IsLeaf()) {
+            costs[u] = SahNodeCost(nodes[u], bboxes[u]);
+            num_node_primitives[u] = 1;
+            collapsed[u] = 1;
+        } else {
+            auto lc = nodes[u].lc_or_id;
+            auto rc = nodes[u].rc;
+            num_node_primitives[u] = num_node_primitives[lc] + num_node_primitives[rc];
+            bool collapse;
+            costs[u] = CollapsedNodeCost(bboxes[u], num_node_primitives[u], costs[lc] + costs[rc], max_leaf_size,
+                collapse);
+            collapsed[u] = collapse ? 1 : 0;
+        }
+    }
+
+    // `order` is a preorder with left children first, nodes below a collapsed node are skipped
+    std::vector<uint32_t> final_nodes;
+    std::vector<uint8_t> dropped(num_nodes, 0);
+    uint32_t num_leaves = 0;
+    for (auto u : order) {
+        if (!dropped[u]) {
+            final_nodes.push_back(u);
+            num_leaves += collapsed[u];
+        }
+        if ((dropped[u] || collapsed[u]) && !nodes[u].IsLeaf()) {
+            dropped[nodes[u].lc_or_id] = 1;
+            dropped[nodes[u].rc] = 1;
+        }
+    }
+
+    std::vector<uint32_t> new_indices(num_nodes);
+    uint32_t num_internals = 0;
+    uint32_t num_visited_leaves = 0;
+    for (auto u : final_nodes) {
+        new_indices[u] = collapsed[u] ? num_leaves - 1 + num_visited_leaves++ : num_internals++;
+    }
+
+    std::vector<AccelNode> old_nodes(nodes, nodes + num_nodes);
+    std::vector<Bbox> old_bboxes(bboxes, bboxes + num_nodes);
+    uint32_t num_visited_primitives = 0;
+    for (auto u : final_nodes) {
+        auto new_index = new_indices[u];
+        if (collapsed[u]) {
+            nodes[new_index] = AccelLeafNode(num_visited_primitives, num_node_primitives[u]);
+            std::vector<uint32_t> leaf_stack { u };
+            while (!leaf_stack.empty()) {
+                auto v = leaf_stack.back();
+                leaf_stack.pop_back();
+                if (old_nodes[v].IsLeaf()) {
+                    primitive_ids[num_visited_primitives++] = old_nodes[v].lc_or_id;
+                } else {
+                    leaf_stack.push_back(old_nodes[v].rc);
+                    leaf_stack.push_back(old_nodes[v].lc_or_id);
+                }
+            }
+        } else {
+            nodes[new_index] = AccelNode { new_indices[old_nodes[u].lc_or_id], new_indices[old_nodes[u].rc] };
+        }
+        bboxes[new_index] = old_bboxes[u];
+    }
+    return num_leaves;
+}
+
+// returns the most entries the traversal stack of the packed tree holds, as `PackAccelWide` does
+template <typename WideNode>
+uint32_t PackAccelWideHost(const AccelNode *nodes, const Bbox *bboxes, WideNode *wide_nodes) {
+    uint32_t num_wide_nodes = 1;
+    uint32_t max_stack_size = 1;
+    // binary node, wide node and entries below it on the traversal stack
+    std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> stack { { 0, 0, 0 } };
+    while (!stack.empty()) {
+        auto [binary_node, wide_node, stack_size] = stack.back();
+        stack.pop_back();
+        uint32_t children[kAccelMaxWidth];
+        auto num_children = CollapseWideChildren(nodes, bboxes, binary_node, kWideNodeWidth<WideNode>, children);
+        max_stack_size = glm::max(max_stack_size, stack_size + num_children);
+        FillWideNode(wide_nodes[wide_node], nodes, bboxes, binary_node, [&](uint32_t child) {
+            stack.emplace_back(child, num_wide_nodes, stack_size + num_children - 1);
+            return num_wide_nodes++;
+        });
+    }
+    return max_stack_size;
+}
+
+// returns the most entries the traversal stack of the packed tree holds, as `PackAccelCompact` does
+uint32_t PackAccelCompactHost(const AccelNode *nodes, const Bbox *bboxes, uint32_t num_leaves,
+    AccelCompactNode *compact_nodes) {
+    for (uint32_t i = 0; i < glm::max(num_leaves, 2u) - 1; i++) {
+        FillCompactNode(compact_nodes[i], nodes, bboxes, i);
+    }
+    uint32_t height = 0;
+    // node and its depth
+    std::vector<std::pair<uint32_t, uint32_t>> stack { { 0, 0 } };
+    while (!stack.empty()) {
+        auto [u, depth] = stack.back();
+        stack.pop_back();
+        if (nodes[u].IsLeaf()) {
+            height = glm::max(height, depth);
+        } else {
+            stack.emplace_back(nodes[u].lc_or_id, depth + 1);
+            stack.emplace_back(nodes[u].rc, depth + 1);
+        }
+    }
+    return height;
+}
+
+AccelBuildStats FinishAccelHost(AccelNode *nodes, Bbox *bboxes, uint32_t num_primitives,
+    const AccelBuildOptions &options, void *packed_nodes, uint32_t *primitive_ids) {
+    AccelBuildStats stats { .num_leaves = num_primitives, .num_references = num_primitives };
+    auto max_leaf_size = glm::clamp(options.max_leaf_size, 1u, kAccelMaxLeafSize);
+    if (options.num_treelet_passes > 0 || (max_leaf_size > 1 && primitive_ids != nullptr)) {
+        stats.initial_sah_cost = CalcAccelSahCostHost(nodes, bboxes);
+    }
+    if (options.num_treelet_passes > 0) {
+        OptimizeAccelTreeletsHost(nodes, bboxes, num_primitives, options.num_treelet_passes);
+    }
+    if (primitive_ids != nullptr) {
+        stats.num_leaves = CollapseAccelLeavesHost(nodes, bboxes, primitive_ids, num_primitives, max_leaf_size);
+    }
+    stats.sah_cost = CalcAccelSahCostHost(nodes, bboxes);
+
+    if (options.layout != AccelLayout::eBinary) {
+        stats.layout = PackAccelHost(nodes, bboxes, stats.num_leaves, options.layout, packed_nodes);
+    }
+
+    return stats;
+}
+
+// spatial splits are only tried where the children of the best object split overlap
+// by more than this fraction of the surface area of the root
+constexpr float kSpatialSplitMinOverlap = 1e-5f;
+
+struct SbvhReference {
+    uint32_t primitive_id;
+    glm::vec3 pmin;
+    glm::vec3 pmax;
+};
+
+// bounds of the part of triangle `p` within [lo, hi] along `axis` and within `ref`,
+// returns false if the part is empty
+bool ClipTriangle(const glm::vec3 *p, const SbvhReference &ref, uint32_t axis, float lo, float hi,
+    glm::vec3 &pmin, glm::vec3 &pmax) {
+    pmin = glm::vec3(FLT_MAX);
+    pmax = glm::vec3(-FLT_MAX);
+    for (uint32_t i = 0; i < 3; i++) {
+        const auto &a = p[i];
+        const auto &b = p[(i + 1) % 3];
+        if (a[axis] >= lo && a[axis] <= hi) {
+            pmin = glm::min(pmin, a);
+            pmax = glm::max(pmax, a);
+        }
+        for (auto plane : { lo, hi }) {
+            if ((a[axis] < plane) != (b[axis] < plane)) {
+                auto q = glm::mix(a, b, (plane - a[axis]) / (b[axis] - a[axis]));
+                q[axis] = plane;
+                pmin = glm::min(pmin, q);
+                pmax = glm::max(pmax, q);
+            }
+        }
+    }
+    pmin = glm::max(pmin, ref.pmin);
+    pmax = glm::min(pmax, ref.pmax);
+    return pmin.x <= pmax.x && pmin.y <= pmax.y && pmin.z <= pmax.z;
+}
+
+}
+
+// follows "Spatial Splits in Bounding Volume Hierarchies" (Stich et al. 2009) without reference unsplitting,
+// each node picks the cheaper of the best binned object split and the best binned spatial split,
+// and spatial splits are given up once they would exceed the reference budget
+uint32_t BuildAccelSbvhHost(AccelNode *nodes, Bbox *bboxes, const glm::vec3 *positions, const uint32_t *indices,
+    uint32_t num_triangles, const AccelBuildOptions &options) {
+    auto num_bins = glm::max(options.num_sah_bins, 2u);
+    auto max_references = AccelMaxReferences(options, num_triangles);
+
+    std::vector<glm::vec3> triangles(3 * num_triangles);
+    std::vector<SbvhReference> refs(num_triangles);
+    for (uint32_t i = 0; i < num_triangles; i++) {
+        auto p = triangles.data() + 3 * i;
+        for (uint32_t j = 0; j < 3; j++) {
+            p[j] = positions[indices[3 * i + j]];
+        }
+        refs[i] = SbvhReference { i, glm::min(p[0], glm::min(p[1], p[2])), glm::max(p[0], glm::max(p[1], p[2])) };
+    }
+
+    // children are written with `kAccelLeafBit` and the index of the leaf until the number of leaves is known
+    struct Task {
+        uint32_t node;
+        std::vector<SbvhReference> refs;
+    };
+    std::vector<AccelNode> internal_nodes;
+    std::vector<SbvhReference> leaves;
+    std::vector<Task> tasks;
+    if (num_triangles > 1) {
+        internal_nodes.push_back(AccelNode {});
+        tasks.push_back(Task { 0, std::move(refs) });
+    } else {
+        leaves = std::move(refs);
+    }
+    uint32_t num_references = num_triangles;
+
+    struct Bin {
+        glm::vec3 pmin;
+        glm::vec3 pmax;
+        uint32_t count;
+        uint32_t num_exits;
+    };
+    std::vector<Bin> bins(num_bins);
+    auto sweep_bins = [&](uint32_t &best_split, uint32_t &best_left, float &best_cost, glm::vec3 &l_best_pmin,
+        glm::vec3 &l_best_pmax, glm::vec3 &r_best_pmin, glm::vec3 &r_best_pmax) {
+        bool found = false;
+        for (uint32_t split = 1; split < num_bins; split++) {
+            glm::vec3 l_pmin(FLT_MAX), l_pmax(-FLT_MAX), r_pmin(FLT_MAX), r_pmax(-FLT_MAX);
+            uint32_t l_count = 0, r_count = 0;
+            for (uint32_t i = 0; i < num_bins; i++) {
+                if (i < split) {
+                    l_pmin = glm::min(l_pmin, bins[i].pmin);
+                    l_pmax = glm::max(l_pmax, bins[i].pmax);
+                    l_count += bins[i].count;
+                } else {
+                    r_pmin = glm::min(r_pmin, bins[i].pmin);
+                    r_pmax = glm::max(r_pmax, bins[i].pmax);
+                    r_count += bins[i].num_exits;
+                }
+            }
+            if (l_count == 0 || r_count == 0) {
+                continue;
+            }
+            auto cost = BboxHalfArea(l_pmin, l_pmax) * l_count + BboxHalfArea(r_pmin, r_pmax) * r_count;
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_split = split;
+                best_left = l_count;
+                l_best_pmin = l_pmin;
+                l_best_pmax = l_pmax;
+                r_best_pmin = r_pmin;
+                r_best_pmax = r_pmax;
+                found = true;
+            }
+        }
+        return found;
+    };
+
+    float root_area = 0.0f;
+    while (!tasks.empty()) {
+        auto task = std::move(tasks.back());
+        tasks.pop_back();
+        auto &task_refs = task.refs;
+        uint32_t num_task_refs = task_refs.size();
+
+        glm::vec3 nmin(FLT_MAX), nmax(-FLT_MAX), cmin(FLT_MAX), cmax(-FLT_MAX);
+        for (const auto &ref : task_refs) {
+            nmin = glm::min(nmin, ref.pmin);
+            nmax = glm::max(nmax, ref.pmax);
+            auto centroid = (ref.pmin + ref.pmax) * 0.5f;
+            cmin = glm::min(cmin, centroid);
+            cmax = glm::max(cmax, centroid);
+        }
+        if (task.node == 0) {
+            root_area = BboxHalfArea(nmin, nmax);
+        }
+
+        // object split, the counts of bins are used as both entries and exits
+        float best_cost = FLT_MAX;
+        uint32_t best_axis = 3;
+        uint32_t best_split = 0;
+        uint32_t num_left = num_task_refs / 2;
+        glm::vec3 l_pmin(FLT_MAX), l_pmax(-FLT_MAX), r_pmin(FLT_MAX), r_pmax(-FLT_MAX);
+        for (uint32_t axis = 0; axis < 3; axis++) {
+            std::fill(bins.begin(), bins.end(), Bin { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX), 0, 0 });
+            for (const auto &ref : task_refs) {
+                auto centroid = (ref.pmin[axis] + ref.pmax[axis]) * 0.5f;
+                auto &bin = bins[SahBinIndex(centroid, cmin[axis], cmax[axis], num_bins)];
+                bin.pmin = glm::min(bin.pmin, ref.pmin);
+                bin.pmax = glm::max(bin.pmax, ref.pmax);
+                ++bin.count;
+                ++bin.num_exits;
+            }
+            if (sweep_bins(best_split, num_left, best_cost, l_pmin, l_pmax, r_pmin, r_pmax)) {
+                best_axis = axis;
+            }
+        }
+
+        auto object_axis = best_axis;
+        auto object_split = best_split;
+
+        // spatial split, bins count the references entering and exiting in them and hold the clipped bounds
+        bool spatial = false;
+        auto overlap_min = glm::max(l_pmin, r_pmin);
+        auto overlap_max = glm::min(l_pmax, r_pmax);
+        auto try_spatial = best_axis == 3 ||
+            BboxHalfArea(overlap_min, overlap_max) > kSpatialSplitMinOverlap * root_area;
+        for (uint32_t axis = 0; axis < 3 && try_spatial && num_references < max_references; axis++) {
+            if (!(nmax[axis] > nmin[axis])) {
+                continue;
+            }
+            auto bin_width = (nmax[axis] - nmin[axis]) / num_bins;
+            std::fill(bins.begin(), bins.end(), Bin { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX), 0, 0 });
+            for (const auto &ref : task_refs) {
+                auto p = triangles.data() + 3 * ref.primitive_id;
+                auto first = SahBinIndex(ref.pmin[axis], nmin[axis], nmax[axis], num_bins);
+                auto last = SahBinIndex(ref.pmax[axis], nmin[axis], nmax[axis], num_bins);
+                for (auto i = first; i <= last; i++) {
+                    glm::vec3 pmin, pmax;
+                    auto lo = i == 0 ? -FLT_MAX : nmin[axis] + i * bin_width;
+                    auto hi = i + 1 == num_bins ? FLT_MAX : nmin[axis] + (i + 1) * bin_width;
+                    if (ClipTriangle(p, ref, axis, lo, hi, pmin, pmax)) {
+                        bins[i].pmin = glm::min(bins[i].pmin, pmin);
+                        bins[i].pmax = glm::max(bins[i].pmax, pmax);
+                    }
+                }
+                ++bins[first].count;
+                ++bins[last].num_exits;
+            }
+            uint32_t spatial_left;
+            glm::vec3 spatial_bounds[4];
+            if (sweep_bins(best_split, spatial_left, best_cost, spatial_bounds[0], spatial_bounds[1],
+                spatial_bounds[2], spatial_bounds[3])) {
+                best_axis = axis;
+                spatial = true;
+            }
+        }
+
+        std::vector<SbvhReference> child_refs[2];
+        if (spatial) {
+            auto plane = nmin[best_axis] + best_split * (nmax[best_axis] - nmin[best_axis]) / num_bins;
+            for (const auto &ref : task_refs) {
+                if (ref.pmax[best_axis] <= plane) {
+                    child_refs[0].push_back(ref);
+                } else if (ref.pmin[best_axis] >= plane) {
+                    child_refs[1].push_back(ref);
+                } else {
+                    auto p = triangles.data() + 3 * ref.primitive_id;
+                    SbvhReference l_ref { ref.primitive_id }, r_ref { ref.primitive_id };
+                    if (ClipTriangle(p, ref, best_axis, -FLT_MAX, plane, l_ref.pmin, l_ref.pmax)) {
+                        child_refs[0].push_back(l_ref);
+                    }
+                    if (ClipTriangle(p, ref, best_axis, plane, FLT_MAX, r_ref.pmin, r_ref.pmax)) {
+                        child_refs[1].push_back(r_ref);
+                    }
+                }
+            }
+            // falls back to an object split if the clipped references don't make progress or break the budget
+            auto num_child_refs = child_refs[0].size() + child_refs[1].size();
+            if (child_refs[0].empty() || child_refs[1].empty() || child_refs[0].size() == num_task_refs ||
+                child_refs[1].size() == num_task_refs ||
+                num_references + num_child_refs - num_task_refs > max_references) {
+                spatial = false;
+                child_refs[0].clear();
+                child_refs[1].clear();
+                best_axis = object_axis;
+                best_split = object_split;
+            } else {
+                num_references += num_child_refs - num_task_refs;
+            }
+        }
+        if (!spatial) {
+            if (best_axis < 3) {
+                std::stable_partition(task_refs.begin(), task_refs.end(), [&](const SbvhReference &ref) {
+                    auto centroid = (ref.pmin[best_axis] + ref.pmax[best_axis]) * 0.5f;
+                    return SahBinIndex(centroid, cmin[best_axis], cmax[best_axis], num_bins) < best_split;
+                });
+            }
+            child_refs[0].assign(task_refs.begin(), task_refs.begin() + num_left);
+            child_refs[1].assign(task_refs.begin() + num_left, task_refs.end());
+        }
+        task_refs.clear();
+        task_refs.shrink_to_fit();
+
+        uint32_t children[2];
+        for (uint32_t i = 0; i < 2; i++) {
+            if (child_refs[i].size() == 1) {
+                children[i] = kAccelLeafBit | static_cast<uint32_t>(leaves.size());
+                leaves.push_back(child_refs[i][0]);
+            } else {
+                children[i] = internal_nodes.size();
+                internal_nodes.push_back(AccelNode {});
+                tasks.push_back(Task { children[i], std::move(child_refs[i]) });
+            }
+        }
+        internal_nodes[task.node] = AccelNode { children[0], children[1] };
+    }
+
+    uint32_t num_leaves = leaves.size();
+    auto num_internal_nodes = num_leaves - 1;
+    auto node_index = [&](uint32_t child) {
+        return child & kAccelLeafBit ? num_internal_nodes + (child & ~kAccelLeafBit) : child;
+    };
+    for (uint32_t i = 0; i < num_internal_nodes; i++) {
+        nodes[i] = AccelNode { node_index(internal_nodes[i].lc_or_id), node_index(internal_nodes[i].rc) };
+    }
+    for (uint32_t i = 0; i < num_leaves; i++) {
+        nodes[num_internal_nodes + i] = AccelLeafNode(leaves[i].primitive_id, 1);
+        bboxes[num_internal_nodes + i] = Bbox {
+            .pmin = glm::vec4(leaves[i].pmin, 1.0f),
+            .pmax = glm::vec4(leaves[i].pmax, 1.0f),
+        };
+    }
+
+    CalcInternalNodesBboxHost(nodes, bboxes);
+    return num_leaves;
+}
+
+AccelBuildStats BuildAccelHost(AccelNode *nodes, Bbox *bboxes, Bbox merged_bbox, uint32_t num_primitives,
+    const AccelBuildOptions &options, void *packed_nodes, uint32_t *primitive_ids) {
+    switch (options.builder) {
+        case AccelBuilder::eLbvh:
+            BuildAccelLbvhHost(nodes, bboxes, num_primitives);
+            break;
+        case AccelBuilder::eSah:
+        case AccelBuilder::eSbvh:
+            BuildAccelSahHost(nodes, bboxes, num_primitives, options);
+            break;
+        case AccelBuilder::ePloc:
+            BuildAccelPlocHost(nodes, bboxes, num_primitives, options);
+            break;
+    }
+
+    return FinishAccelHost(nodes, bboxes, num_primitives, options, packed_nodes, primitive_ids);
+}
+
+AccelBuildStats BuildAccelSpatialHost(AccelNode *nodes, Bbox *bboxes, const glm::vec3 *positions,
+    const uint32_t *indices, uint32_t num_triangles, const AccelBuildOptions &options, void *packed_nodes,
+    uint32_t *primitive_ids) {
+    auto num_references = BuildAccelSbvhHost(nodes, bboxes, positions, indices, num_triangles, options);
+    return FinishAccelHost(nodes, bboxes, num_references, options, packed_nodes, primitive_ids);
+}
+
+AccelLayout PackAccelHost(const AccelNode *nodes, const Bbox *bboxes, uint32_t num_leaves, AccelLayout layout,
+    void *packed_nodes) {
+    uint32_t stack_size = 0;
+    auto max_stack_size = kAccelWideStackSize;
+    switch (layout) {
+        case AccelLayout::eWide4:
+            stack_size = PackAccelWideHost(nodes, bboxes, reinterpret_cast<AccelWideNode<4> *>(packed_nodes));
+            break;
+        case AccelLayout::eWide8:
+            stack_size = PackAccelWideHost(nodes, bboxes, reinterpret_cast<AccelWideNode<8> *>(packed_nodes));
+            break;
+        case AccelLayout::eQuantized:
+            stack_size = PackAccelWideHost(nodes, bboxes, reinterpret_cast<AccelQuantizedNode *>(packed_nodes));
+            break;
+        case AccelLayout::eCompact:
+            stack_size = PackAccelCompactHost(nodes, bboxes, num_leaves,
+                reinterpret_cast<AccelCompactNode *>(packed_nodes));
+            max_stack_size = kAccelStackSize;
+            break;
+        case AccelLayout::eStackless:
+            break;
+        default:
+            return layout;
+    }
+    if (layout != AccelLayout::eStackless && stack_size <= max_stack_size) {
+        return layout;
+    }
+    auto parents = reinterpret_cast<uint32_t *>(packed_nodes);
+    for (uint32_t i = 0; i + 1 < num_leaves; i++) {
+        parents[nodes[i].lc_or_id] = i;
+        parents[nodes[i].rc] = i;
+    }
+    return AccelLayout::eStackless;
+}
+
+AccelRefitStats RefitAccelHost(AccelNode *nodes, Bbox *bboxes, const Bbox *primitive_bboxes, const uint32_t *primitive_ids,
+    uint32_t num_leaves, AccelLayout layout, void *packed_nodes) {
+    for (uint32_t i = 0; i < num_leaves; i++) {
+        auto u = num_leaves - 1 + i;
+        bboxes[u] = RefitLeafBbox(nodes[u], primitive_bboxes, primitive_ids);
+    }
+    CalcInternalNodesBboxHost(nodes, bboxes);
+
+    AccelRefitStats stats {};
+    if (layout != AccelLayout::eBinary) {
+        stats.layout = PackAccelHost(nodes, bboxes, num_leaves, layout, packed_nodes);
+    }
+    stats.sah_cost = CalcAccelSahCostHost(nodes, bboxes);
+    return stats;
+}
+
+float CalcAccelSahCostHost(const AccelNode *nodes, const Bbox *bboxes) {
+    float cost = 0.0f;
+    std::vector<uint32_t> stack { 0 };
+    while (!stack.empty()) {
+        auto u = stack.back();
+        stack.pop_back();
+        cost += SahNodeCost(nodes[u], bboxes[u]);
+        if (!nodes[u].IsLeaf()) {
+            stack.push_back(nodes[u].lc_or_id);
+            stack.push_back(nodes[u].rc);
+        }
+    }
+    auto root_area = BboxHalfArea(bboxes[0]);
+    return root_area > 0.0f ? cost / root_area : 0.0f;
+}
+
+AccelAnalysis AnalyzeAccelHost(const AccelNode *nodes, const Bbox *bboxes, uint32_t num_leaves,
+    uint32_t num_primitive_ids, AccelLayout layout) {
+    AccelAnalysis analysis {};
+    analysis.sah_cost = CalcAccelSahCostHost(nodes, bboxes);
+
+    uint64_t depth_sum = 0;
+    float overlap = 0.0f;
+    std::vector<std::pair<uint32_t, uint32_t>> stack { { 0, 0 } };
+    while (!stack.empty()) {
+        auto [u, depth] = stack.back();
+        stack.pop_back();
+        const auto &node = nodes[u];
+        if (node.IsLeaf()) {
+            analysis.max_depth = glm::max(analysis.max_depth, depth);
+            depth_sum += depth;
+            ++analysis.leaf_size_histogram[glm::clamp(node.NumPrimitives(), 1u, kAccelMaxLeafSize) - 1];
+            // a binary traversal reaching a leaf at depth d needs d + 1 stack entries
+            if (depth + 1 > kAccelStackSize) {
+                ++analysis.num_deep_leaves;
+            }
+        } else {
+            const auto &l_bbox = bboxes[node.lc_or_id];
+            const auto &r_bbox = bboxes[node.rc];
+            overlap += BboxHalfArea(glm::vec3(glm::max(l_bbox.pmin, r_bbox.pmin)),
+                glm::vec3(glm::min(l_bbox.pmax, r_bbox.pmax)));
+            stack.emplace_back(node.lc_or_id, depth + 1);
+            stack.emplace_back(node.rc, depth + 1);
+        }
+    }
+    analysis.average_depth = static_cast<float>(depth_sum) / num_leaves;
+    auto root_area = BboxHalfArea(bboxes[0]);
+    analysis.sibling_overlap = root_area > 0.0f ? overlap / root_area : 0.0f;
+
+    analysis.memory_size = (sizeof(AccelNode) + sizeof(Bbox)) * (2 * num_leaves - 1) +
+        AccelPackedNodesSize(layout, num_leaves) + sizeof(uint32_t) * num_primitive_ids;
+    return analysis;
+}
+
+}
@@ -0,0 +1,115 @@
+#include "accel_build_common.cuh"
+
+namespace kernel {
+
+namespace {
+
+CU_GLOBAL void InitPlocClusters(uint32_t *clusters, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+
+    clusters[index] = num_primitives - 1 + index;
+}
+
+CU_GLOBAL void FindPlocNeighbours(const uint32_t *clusters, const Bbox *bboxes, uint32_t *neighbours,
+    uint32_t num_clusters, uint32_t radius) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_clusters) {
+        return;
+    }
+
+    neighbours[index] = FindNearestCluster(clusters, bboxes, index, num_clusters, radius);
+}
+
+// mutual nearest neighbours are merged into the lower one, the higher one is removed
+CU_GLOBAL void MarkPlocMerges(const uint32_t *neighbours, uint32_t *merges, uint32_t *keeps, uint32_t num_clusters) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_clusters) {
+        return;
+    }
+
+    auto neighbour = neighbours[index];
+    auto mutual = neighbours[neighbour] == index;
+    merges[index] = mutual && index < neighbour ? 1 : 0;
+    keeps[index] = mutual && index > neighbour ? 0 : 1;
+}
+
+// new internal nodes are allocated downwards from `next_node` so that the last merge becomes the root
+CU_GLOBAL void MergePlocClusters(AccelNode *nodes, Bbox *bboxes, const uint32_t *clusters, const uint32_t *neighbours,
+    const uint32_t *merges, const uint32_t *merge_offsets, const uint32_t *keeps, const uint32_t *keep_offsets,
+    uint32_t *next_clusters, uint32_t next_node, uint32_t num_clusters) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_clusters || !keeps[index]) {
+        return;
+    }
+
+    auto cluster = clusters[index];
+    if (merges[index]) {
+        auto other = clusters[neighbours[index]];
+        auto node = next_node - merge_offsets[index];
+        nodes[node] = AccelNode { cluster, other };
+        bboxes[node].pmin = glm::min(bboxes[cluster].pmin, bboxes[other].pmin);
+        bboxes[node].pmax = glm::max(bboxes[cluster].pmax, bboxes[other].pmax);
+        cluster = node;
+    }
+    next_clusters[keep_offsets[index]] = cluster;
+}
+
+}
+
+size_t AccelPlocScratchSize(uint32_t num_primitives) {
+    return CuScratch::PieceSize(sizeof(uint64_t) * num_primitives) + SortLeavesScratchSize(num_primitives)
+        + CuScratch::PieceSize(sizeof(uint32_t) * num_primitives * 2)
+        + CuScratch::PieceSize(sizeof(uint32_t) * num_primitives * 5)
+        + ExclusiveSumScratchSize<uint32_t>(num_primitives);
+}
+
+void BuildAccelPloc(AccelNode *nodes, Bbox *bboxes, uint32_t num_primitives, const AccelBuildOptions &options,
+    CuScratch &scratch) {
+    auto radius = glm::max(options.ploc_radius, 1u);
+
+    CuScratch::Scope scope(scratch);
+    auto morton_codes = scratch.Allocate<uint64_t>(num_primitives);
+    SortLeavesByMortonCode(nodes, bboxes, morton_codes, num_primitives, scratch);
+
+    auto clusters_gpu = scratch.Allocate<uint32_t>(num_primitives * 2);
+    uint32_t *clusters[2] = { clusters_gpu, clusters_gpu + num_primitives };
+    auto threads = BlockSizeOf<InitPlocClusters>();
+    InitPlocClusters<<<(num_primitives + threads - 1) / threads, threads>>>(clusters[0], num_primitives);
+
+    auto neighbours = scratch.Allocate<uint32_t>(num_primitives * 5);
+    auto merges = neighbours + num_primitives;
+    auto merge_offsets = merges + num_primitives;
+    auto keeps = merge_offsets + num_primitives;
+    auto keep_offsets = keeps + num_primitives;
+
+    auto neighbour_threads = BlockSizeOf<FindPlocNeighbours>();
+    auto mark_threads = BlockSizeOf<MarkPlocMerges>();
+    auto merge_threads = BlockSizeOf<MergePlocClusters>();
+    uint32_t curr = 0;
+    uint32_t num_clusters = num_primitives;
+    uint32_t next_node = num_primitives - 1;
+    while (num_clusters > 1) {
+        FindPlocNeighbours<<<(num_clusters + neighbour_threads - 1) / neighbour_threads, neighbour_threads>>>(
+            clusters[curr], bboxes, neighbours, num_clusters, radius);
+        MarkPlocMerges<<<(num_clusters + mark_threads - 1) / mark_threads, mark_threads>>>(
+            neighbours, merges, keeps, num_clusters);
+        ExclusiveSum(merges, merge_offsets, num_clusters, scratch);
+        ExclusiveSum(keeps, keep_offsets, num_clusters, scratch);
+        MergePlocClusters<<<(num_clusters + merge_threads - 1) / merge_threads, merge_threads>>>(
+            nodes, bboxes, clusters[curr], neighbours, merges, merge_offsets, keeps, keep_offsets, clusters[curr ^ 1],
+            next_node - 1, num_clusters);
+
+        uint32_t last_keep[2];
+        cudaMemcpy(&last_keep[0], keeps + num_clusters - 1, sizeof(uint32_t), cudaMemcpyDeviceToHost);
+        cudaMemcpy(&last_keep[1], keep_offsets + num_clusters - 1, sizeof(uint32_t), cudaMemcpyDeviceToHost);
+        auto num_next_clusters = last_keep[0] + last_keep[1];
+        next_node -= num_clusters - num_next_clusters;
+        num_clusters = num_next_clusters;
+        curr ^= 1;
+    }
+}
+
+}
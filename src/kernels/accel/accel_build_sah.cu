@@ -0,0 +1,363 @@
+#include "accel_build_common.cuh"
+
+#include <thrust/sequence.h>
+#include <thrust/system/cuda/execution_policy.h>
+
+namespace kernel {
+
+namespace {
+
+// bounds the bin memory, levels with more tasks are binned in several passes
+constexpr uint32_t kMaxTasksPerPass = 8192;
+
+constexpr uint32_t kMedianSplitAxis = 3;
+
+struct SahTask {
+    uint32_t node;
+    uint32_t begin;
+    uint32_t end;
+};
+
+struct SahBin {
+    Bbox bbox;
+    uint32_t count;
+};
+
+struct SahSplit {
+    uint32_t axis;
+    uint32_t bin;
+    uint32_t num_left;
+};
+
+struct SahCounters {
+    uint32_t num_nodes;
+    uint32_t num_next_tasks;
+};
+
+CU_GLOBAL void InitSahBboxes(Bbox *bboxes, uint32_t count) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= count) {
+        return;
+    }
+
+    bboxes[index].pmin = glm::vec4(FLT_MAX, FLT_MAX, FLT_MAX, 1.0f);
+    bboxes[index].pmax = glm::vec4(-FLT_MAX, -FLT_MAX, -FLT_MAX, 1.0f);
+}
+
+CU_GLOBAL void InitSahBins(SahBin *bins, uint32_t count) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= count) {
+        return;
+    }
+
+    bins[index].bbox.pmin = glm::vec4(FLT_MAX, FLT_MAX, FLT_MAX, 1.0f);
+    bins[index].bbox.pmax = glm::vec4(-FLT_MAX, -FLT_MAX, -FLT_MAX, 1.0f);
+    bins[index].count = 0;
+}
+
+CU_GLOBAL void CalcSahCentroidBounds(const uint32_t *prim_ids, const uint32_t *prim_tasks, const Bbox *prim_bboxes,
+    Bbox *centroid_bounds, uint32_t task_offset, uint32_t num_tasks, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+    auto task = prim_tasks[index] - task_offset;
+    if (task >= num_tasks) {
+        return;
+    }
+
+    auto centroid = BboxCentroid(prim_bboxes[prim_ids[index]]);
+    atomicMergeBbox(centroid_bounds[task], centroid, centroid);
+}
+
+CU_GLOBAL void BinSahPrimitives(const uint32_t *prim_ids, const uint32_t *prim_tasks, const Bbox *prim_bboxes,
+    const Bbox *centroid_bounds, SahBin *bins, uint32_t task_offset, uint32_t num_tasks, uint32_t num_bins,
+    uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+    auto task = prim_tasks[index] - task_offset;
+    if (task >= num_tasks) {
+        return;
+    }
+
+    const auto &bbox = prim_bboxes[prim_ids[index]];
+    auto centroid = BboxCentroid(bbox);
+    const auto &bounds = centroid_bounds[task];
+    for (uint32_t axis = 0; axis < 3; axis++) {
+        auto bin_index = SahBinIndex(centroid[axis], bounds.pmin[axis], bounds.pmax[axis], num_bins);
+        auto &bin = bins[(task * 3 + axis) * num_bins + bin_index];
+        atomicAdd(&bin.count, 1u);
+        atomicMergeBbox(bin.bbox, glm::vec3(bbox.pmin), glm::vec3(bbox.pmax));
+    }
+}
+
+CU_GLOBAL void EvalSahSplits(const SahBin *bins, float *costs, uint32_t num_tasks, uint32_t num_bins) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    auto num_splits = num_bins - 1;
+    if (index >= num_tasks * 3 * num_splits) {
+        return;
+    }
+    auto split = index % num_splits + 1;
+    auto axis_bins = bins + index / num_splits * num_bins;
+
+    glm::vec3 l_pmin(FLT_MAX), l_pmax(-FLT_MAX), r_pmin(FLT_MAX), r_pmax(-FLT_MAX);
+    uint32_t l_count = 0, r_count = 0;
+    for (uint32_t i = 0; i < num_bins; i++) {
+        const auto &bin = axis_bins[i];
+        if (bin.count == 0) {
+            continue;
+        }
+        if (i < split) {
+            l_pmin = glm::min(l_pmin, glm::vec3(bin.bbox.pmin));
+            l_pmax = glm::max(l_pmax, glm::vec3(bin.bbox.pmax));
+            l_count += bin.count;
+        } else {
+            r_pmin = glm::min(r_pmin, glm::vec3(bin.bbox.pmin));
+            r_pmax = glm::max(r_pmax, glm::vec3(bin.bbox.pmax));
+            r_count += bin.count;
+        }
+    }
+
+    costs[index] = l_count == 0 || r_count == 0 ? FLT_MAX
+        : BboxHalfArea(l_pmin, l_pmax) * l_count + BboxHalfArea(r_pmin, r_pmax) * r_count;
+}
+
+CU_GLOBAL void ChooseSahSplits(const SahTask *tasks, const SahBin *bins, const float *costs, SahSplit *splits,
+    SahTask *next_tasks, uint32_t *next_task_of, SahCounters *counters, AccelNode *nodes, uint32_t *parents,
+    uint32_t task_offset, uint32_t num_tasks, uint32_t num_bins, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_tasks) {
+        return;
+    }
+    auto task_index = task_offset + index;
+    auto task = tasks[task_index];
+
+    auto num_splits = num_bins - 1;
+    auto task_costs = costs + index * 3 * num_splits;
+    float best_cost = FLT_MAX;
+    uint32_t best = ~0u;
+    for (uint32_t i = 0; i < 3 * num_splits; i++) {
+        if (task_costs[i] < best_cost) {
+            best_cost = task_costs[i];
+            best = i;
+        }
+    }
+
+    SahSplit split;
+    if (best != ~0u) {
+        split.axis = best / num_splits;
+        split.bin = best % num_splits + 1;
+        split.num_left = 0;
+        auto axis_bins = bins + (index * 3 + split.axis) * num_bins;
+        for (uint32_t i = 0; i < split.bin; i++) {
+            split.num_left += axis_bins[i].count;
+        }
+    } else {
+        split.axis = kMedianSplitAxis;
+        split.bin = 0;
+        split.num_left = (task.end - task.begin) / 2;
+    }
+    splits[task_index] = split;
+
+    uint32_t children[2];
+    SahTask child_tasks[2] = {
+        { 0, task.begin, task.begin + split.num_left },
+        { 0, task.begin + split.num_left, task.end },
+    };
+    for (uint32_t i = 0; i < 2; i++) {
+        auto &child_task = child_tasks[i];
+        if (child_task.end - child_task.begin == 1) {
+            children[i] = num_primitives - 1 + child_task.begin;
+            next_task_of[task_index * 2 + i] = ~0u;
+        } else {
+            children[i] = atomicAdd(&counters->num_nodes, 1u);
+            child_task.node = children[i];
+            auto next_index = atomicAdd(&counters->num_next_tasks, 1u);
+            next_tasks[next_index] = child_task;
+            next_task_of[task_index * 2 + i] = next_index;
+        }
+        parents[children[i]] = task.node;
+    }
+    nodes[task.node].lc_or_id = children[0];
+    nodes[task.node].rc = children[1];
+}
+
+CU_GLOBAL void MarkSahSides(const uint32_t *prim_ids, const uint32_t *prim_tasks, const Bbox *prim_bboxes,
+    const SahTask *tasks, const SahSplit *splits, const Bbox *centroid_bounds, uint32_t *sides,
+    uint32_t task_offset, uint32_t num_tasks, uint32_t num_bins, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+    auto task = prim_tasks[index] - task_offset;
+    if (task >= num_tasks) {
+        return;
+    }
+
+    auto task_index = task_offset + task;
+    const auto &split = splits[task_index];
+    bool is_left;
+    if (split.axis == kMedianSplitAxis) {
+        is_left = index - tasks[task_index].begin < split.num_left;
+    } else {
+        auto centroid = BboxCentroid(prim_bboxes[prim_ids[index]]);
+        const auto &bounds = centroid_bounds[task];
+        is_left = SahBinIndex(centroid[split.axis], bounds.pmin[split.axis], bounds.pmax[split.axis], num_bins)
+            < split.bin;
+    }
+    sides[index] = is_left ? 1 : 0;
+}
+
+CU_GLOBAL void PartitionSahPrimitives(const uint32_t *prim_ids, const uint32_t *prim_tasks, const SahTask *tasks,
+    const SahSplit *splits, const uint32_t *next_task_of, const uint32_t *sides, const uint32_t *left_offsets,
+    uint32_t *out_prim_ids, uint32_t *out_prim_tasks, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+    auto task_index = prim_tasks[index];
+    if (task_index == ~0u) {
+        out_prim_ids[index] = prim_ids[index];
+        out_prim_tasks[index] = ~0u;
+        return;
+    }
+
+    auto task = tasks[task_index];
+    auto num_left_before = left_offsets[index] - left_offsets[task.begin];
+    uint32_t dst;
+    uint32_t child;
+    if (sides[index]) {
+        dst = task.begin + num_left_before;
+        child = 0;
+    } else {
+        dst = task.begin + splits[task_index].num_left + (index - task.begin - num_left_before);
+        child = 1;
+    }
+    out_prim_ids[dst] = prim_ids[index];
+    out_prim_tasks[dst] = next_task_of[task_index * 2 + child];
+}
+
+CU_GLOBAL void FillSahLeafNodes(AccelNode *nodes, Bbox *bboxes, const uint32_t *prim_ids, const Bbox *prim_bboxes,
+    uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+
+    auto prim_id = prim_ids[index];
+    nodes[num_primitives - 1 + index] = AccelLeafNode(prim_id, 1);
+    bboxes[num_primitives - 1 + index] = prim_bboxes[prim_id];
+}
+
+}
+
+size_t AccelSahScratchSize(uint32_t num_primitives, const AccelBuildOptions &options) {
+    auto num_bins = glm::max(options.num_sah_bins, 2u);
+    auto max_tasks = num_primitives / 2 + 1;
+    auto pass_tasks = glm::min(max_tasks, kMaxTasksPerPass);
+    return CuScratch::PieceSize(sizeof(Bbox) * num_primitives)
+        + 3 * CuScratch::PieceSize(sizeof(uint32_t) * num_primitives * 2)
+        + CuScratch::PieceSize(sizeof(uint32_t) * (2 * num_primitives - 1))
+        + CuScratch::PieceSize(sizeof(SahTask) * max_tasks * 2) + CuScratch::PieceSize(sizeof(SahSplit) * max_tasks)
+        + CuScratch::PieceSize(sizeof(uint32_t) * max_tasks * 2) + CuScratch::PieceSize(sizeof(Bbox) * pass_tasks)
+        + CuScratch::PieceSize(sizeof(SahBin) * pass_tasks * 3 * num_bins)
+        + CuScratch::PieceSize(sizeof(float) * pass_tasks * 3 * (num_bins - 1))
+        + CuScratch::PieceSize(sizeof(SahCounters)) + ExclusiveSumScratchSize<uint32_t>(num_primitives)
+        + UpdateInternalNodesBboxScratchSize(num_primitives);
+}
+
+void BuildAccelSah(AccelNode *nodes, Bbox *bboxes, uint32_t num_primitives,
+    const AccelBuildOptions &options, CuScratch &scratch) {
+    auto num_internal_nodes = num_primitives - 1;
+    auto num_bins = glm::max(options.num_sah_bins, 2u);
+    auto max_tasks = num_primitives / 2 + 1;
+
+    CuScratch::Scope scope(scratch);
+    auto prim_bboxes = scratch.Allocate<Bbox>(num_primitives);
+    cudaMemcpy(prim_bboxes, bboxes + num_internal_nodes, sizeof(Bbox) * num_primitives, cudaMemcpyDeviceToDevice);
+
+    auto prim_ids_gpu = scratch.Allocate<uint32_t>(num_primitives * 2);
+    uint32_t *prim_ids[2] = { prim_ids_gpu, prim_ids_gpu + num_primitives };
+    thrust::sequence(thrust::cuda::par(scratch), prim_ids[0], prim_ids[0] + num_primitives);
+
+    auto prim_tasks_gpu = scratch.Allocate<uint32_t>(num_primitives * 2);
+    uint32_t *prim_tasks[2] = { prim_tasks_gpu, prim_tasks_gpu + num_primitives };
+    cudaMemset(prim_tasks[0], 0, sizeof(uint32_t) * num_primitives);
+
+    auto sides = scratch.Allocate<uint32_t>(num_primitives * 2);
+    auto left_offsets = sides + num_primitives;
+
+    auto parents = scratch.Allocate<uint32_t>(num_primitives + num_internal_nodes);
+
+    auto tasks_gpu = scratch.Allocate<SahTask>(max_tasks * 2);
+    SahTask *tasks[2] = { tasks_gpu, tasks_gpu + max_tasks };
+    SahTask root_task { 0, 0, num_primitives };
+    cudaMemcpy(tasks_gpu, &root_task, sizeof(root_task), cudaMemcpyHostToDevice);
+    auto splits = scratch.Allocate<SahSplit>(max_tasks);
+    auto next_task_of = scratch.Allocate<uint32_t>(max_tasks * 2);
+
+    auto pass_tasks = glm::min(max_tasks, kMaxTasksPerPass);
+    auto centroid_bounds = scratch.Allocate<Bbox>(pass_tasks);
+    auto bins = scratch.Allocate<SahBin>(pass_tasks * 3 * num_bins);
+    auto costs = scratch.Allocate<float>(pass_tasks * 3 * (num_bins - 1));
+
+    SahCounters counters { 1, 0 };
+    auto counters_gpu = scratch.Allocate<SahCounters>(1);
+    cudaMemcpy(counters_gpu, &counters, sizeof(counters), cudaMemcpyHostToDevice);
+
+    uint32_t curr = 0;
+    uint32_t num_tasks = num_primitives > 1 ? 1 : 0;
+    while (num_tasks > 0) {
+        cudaMemset(&counters_gpu->num_next_tasks, 0, sizeof(uint32_t));
+        cudaMemset(sides, 0, sizeof(uint32_t) * num_primitives);
+
+        for (uint32_t task_offset = 0; task_offset < num_tasks; task_offset += pass_tasks) {
+            auto num_pass_tasks = glm::min(num_tasks - task_offset, pass_tasks);
+            auto num_pass_bins = num_pass_tasks * 3 * num_bins;
+            auto num_pass_splits = num_pass_tasks * 3 * (num_bins - 1);
+
+            auto threads = BlockSizeOf<InitSahBboxes>();
+            InitSahBboxes<<<(num_pass_tasks + threads - 1) / threads, threads>>>(centroid_bounds, num_pass_tasks);
+            threads = BlockSizeOf<CalcSahCentroidBounds>();
+            CalcSahCentroidBounds<<<(num_primitives + threads - 1) / threads, threads>>>(prim_ids[curr],
+                prim_tasks[curr], prim_bboxes, centroid_bounds, task_offset, num_pass_tasks, num_primitives);
+
+            threads = BlockSizeOf<InitSahBins>();
+            InitSahBins<<<(num_pass_bins + threads - 1) / threads, threads>>>(bins, num_pass_bins);
+            threads = BlockSizeOf<BinSahPrimitives>();
+            BinSahPrimitives<<<(num_primitives + threads - 1) / threads, threads>>>(prim_ids[curr], prim_tasks[curr],
+                prim_bboxes, centroid_bounds, bins, task_offset, num_pass_tasks, num_bins, num_primitives);
+
+            threads = BlockSizeOf<EvalSahSplits>();
+            EvalSahSplits<<<(num_pass_splits + threads - 1) / threads, threads>>>(
+                bins, costs, num_pass_tasks, num_bins);
+            threads = BlockSizeOf<ChooseSahSplits>();
+            ChooseSahSplits<<<(num_pass_tasks + threads - 1) / threads, threads>>>(tasks[curr], bins, costs,
+                splits, tasks[curr ^ 1], next_task_of, counters_gpu, nodes, parents,
+                task_offset, num_pass_tasks, num_bins, num_primitives);
+
+            threads = BlockSizeOf<MarkSahSides>();
+            MarkSahSides<<<(num_primitives + threads - 1) / threads, threads>>>(prim_ids[curr], prim_tasks[curr],
+                prim_bboxes, tasks[curr], splits, centroid_bounds, sides, task_offset, num_pass_tasks, num_bins,
+                num_primitives);
+        }
+
+        ExclusiveSum(sides, left_offsets, num_primitives, scratch);
+        auto threads = BlockSizeOf<PartitionSahPrimitives>();
+        PartitionSahPrimitives<<<(num_primitives + threads - 1) / threads, threads>>>(prim_ids[curr],
+            prim_tasks[curr], tasks[curr], splits, next_task_of, sides, left_offsets, prim_ids[curr ^ 1],
+            prim_tasks[curr ^ 1], num_primitives);
+
+        curr ^= 1;
+        cudaMemcpy(&num_tasks, &counters_gpu->num_next_tasks, sizeof(uint32_t), cudaMemcpyDeviceToHost);
+    }
+
+    auto threads = BlockSizeOf<FillSahLeafNodes>();
+    FillSahLeafNodes<<<(num_primitives + threads - 1) / threads, threads>>>(nodes, bboxes, prim_ids[curr],
+        prim_bboxes, num_primitives);
+    UpdateInternalNodesBbox(nodes, parents, bboxes, num_primitives, scratch);
+}
+
+}
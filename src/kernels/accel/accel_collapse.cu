@@ -0,0 +1,143 @@
+#include "accel_build_common.cuh"
+
+namespace kernel {
+
+namespace {
+
+// the second thread arriving at a node continues upwards so that both subtrees are done when a node is visited
+CU_GLOBAL void CalcCollapseCosts(const AccelNode *nodes, const Bbox *bboxes, const uint32_t *parents, float *costs,
+    uint32_t *num_node_primitives, uint32_t *num_final_leaves, uint8_t *collapsed, uint32_t *visits,
+    uint32_t num_primitives, uint32_t max_leaf_size) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+
+    uint32_t u = num_primitives - 1 + index;
+    costs[u] = SahNodeCost(nodes[u], bboxes[u]);
+    num_node_primitives[u] = 1;
+    num_final_leaves[u] = 1;
+    collapsed[u] = 1;
+    while (u != 0) {
+        u = parents[u];
+        __threadfence();
+        if (atomicAdd(&visits[u], 1u) == 0) {
+            return;
+        }
+        __threadfence();
+
+        // children were written by the other thread arriving here
+        auto lc = nodes[u].lc_or_id;
+        auto rc = nodes[u].rc;
+        num_node_primitives[u] = LoadVolatile(num_node_primitives[lc]) + LoadVolatile(num_node_primitives[rc]);
+        bool collapse;
+        auto children_cost = LoadVolatile(costs[lc]) + LoadVolatile(costs[rc]);
+        costs[u] = CollapsedNodeCost(bboxes[u], num_node_primitives[u], children_cost, max_leaf_size, collapse);
+        num_final_leaves[u] = collapse ? 1 : LoadVolatile(num_final_leaves[lc]) + LoadVolatile(num_final_leaves[rc]);
+        collapsed[u] = collapse ? 1 : 0;
+    }
+}
+
+// positions of a node in the collapsed tree are found by summing up what precedes it on the way to the root,
+// nodes below a collapsed node are dropped but still place their primitive
+CU_GLOBAL void AssignCollapsedNodes(const AccelNode *nodes, const uint32_t *parents,
+    const uint32_t *num_node_primitives, const uint32_t *num_final_leaves, const uint8_t *collapsed,
+    uint32_t *new_indices, uint32_t *first_primitives, uint32_t *primitive_ids, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= 2 * num_primitives - 1) {
+        return;
+    }
+
+    uint32_t first_primitive = 0;
+    uint32_t leaf_index = 0;
+    uint32_t internal_index = 0;
+    bool dropped = false;
+    uint32_t u = index;
+    while (u != 0) {
+        auto pa = parents[u];
+        dropped |= collapsed[pa] != 0;
+        internal_index += 1;
+        if (nodes[pa].rc == u) {
+            auto sibling = nodes[pa].lc_or_id;
+            first_primitive += num_node_primitives[sibling];
+            leaf_index += num_final_leaves[sibling];
+            internal_index += num_final_leaves[sibling] - 1;
+        }
+        u = pa;
+    }
+
+    if (nodes[index].IsLeaf()) {
+        primitive_ids[first_primitive] = nodes[index].lc_or_id;
+    }
+    if (dropped) {
+        new_indices[index] = ~0u;
+    } else {
+        new_indices[index] = collapsed[index] ? num_final_leaves[0] - 1 + leaf_index : internal_index;
+        first_primitives[index] = first_primitive;
+    }
+}
+
+CU_GLOBAL void WriteCollapsedNodes(AccelNode *nodes, Bbox *bboxes, const AccelNode *old_nodes,
+    const Bbox *old_bboxes, const uint32_t *num_node_primitives, const uint8_t *collapsed,
+    const uint32_t *new_indices, const uint32_t *first_primitives, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= 2 * num_primitives - 1 || new_indices[index] == ~0u) {
+        return;
+    }
+
+    auto new_index = new_indices[index];
+    if (collapsed[index]) {
+        nodes[new_index] = AccelLeafNode(first_primitives[index], num_node_primitives[index]);
+    } else {
+        const auto &node = old_nodes[index];
+        nodes[new_index] = AccelNode { new_indices[node.lc_or_id], new_indices[node.rc] };
+    }
+    bboxes[new_index] = old_bboxes[index];
+}
+
+}
+
+size_t AccelCollapseScratchSize(uint32_t num_primitives) {
+    auto num_nodes = 2 * num_primitives - 1;
+    return 6 * CuScratch::PieceSize(sizeof(uint32_t) * num_nodes) + CuScratch::PieceSize(sizeof(float) * num_nodes)
+        + CuScratch::PieceSize(sizeof(uint8_t) * num_nodes) + CuScratch::PieceSize(sizeof(AccelNode) * num_nodes)
+        + CuScratch::PieceSize(sizeof(Bbox) * num_nodes);
+}
+
+uint32_t CollapseAccelLeaves(AccelNode *nodes, Bbox *bboxes, uint32_t *primitive_ids, uint32_t num_primitives,
+    uint32_t max_leaf_size, CuScratch &scratch) {
+    auto num_nodes = 2 * num_primitives - 1;
+    CuScratch::Scope scope(scratch);
+    auto parents = scratch.Allocate<uint32_t>(num_nodes);
+    CalcAccelParents(nodes, parents, num_primitives);
+
+    auto costs = scratch.Allocate<float>(num_nodes);
+    auto num_node_primitives = scratch.Allocate<uint32_t>(num_nodes);
+    auto num_final_leaves = scratch.Allocate<uint32_t>(num_nodes);
+    auto collapsed = scratch.Allocate<uint8_t>(num_nodes);
+    auto visits = scratch.Allocate<uint32_t>(num_nodes);
+    cudaMemset(visits, 0, sizeof(uint32_t) * num_nodes);
+    auto threads = BlockSizeOf<CalcCollapseCosts>();
+    CalcCollapseCosts<<<(num_primitives + threads - 1) / threads, threads>>>(nodes, bboxes, parents, costs,
+        num_node_primitives, num_final_leaves, collapsed, visits, num_primitives, max_leaf_size);
+
+    auto new_indices = scratch.Allocate<uint32_t>(num_nodes);
+    auto first_primitives = scratch.Allocate<uint32_t>(num_nodes);
+    threads = BlockSizeOf<AssignCollapsedNodes>();
+    AssignCollapsedNodes<<<(num_nodes + threads - 1) / threads, threads>>>(nodes, parents, num_node_primitives,
+        num_final_leaves, collapsed, new_indices, first_primitives, primitive_ids, num_primitives);
+
+    auto old_nodes = scratch.Allocate<AccelNode>(num_nodes);
+    cudaMemcpy(old_nodes, nodes, sizeof(AccelNode) * num_nodes, cudaMemcpyDeviceToDevice);
+    auto old_bboxes = scratch.Allocate<Bbox>(num_nodes);
+    cudaMemcpy(old_bboxes, bboxes, sizeof(Bbox) * num_nodes, cudaMemcpyDeviceToDevice);
+    threads = BlockSizeOf<WriteCollapsedNodes>();
+    WriteCollapsedNodes<<<(num_nodes + threads - 1) / threads, threads>>>(nodes, bboxes, old_nodes, old_bboxes,
+        num_node_primitives, collapsed, new_indices, first_primitives, num_primitives);
+
+    uint32_t num_leaves;
+    cudaMemcpy(&num_leaves, num_final_leaves, sizeof(uint32_t), cudaMemcpyDeviceToHost);
+    return num_leaves;
+}
+
+}
@@ -0,0 +1,200 @@
+#include "accel_build_common.cuh"
+
+namespace kernel {
+
+namespace {
+
+struct WideTask {
+    uint32_t binary_node;
+    uint32_t wide_node;
+    // entries a traversal holds on its stack below the node when it pops it
+    uint32_t stack_size;
+};
+
+struct WideCounters {
+    uint32_t num_nodes;
+    uint32_t num_next_tasks;
+    uint32_t max_stack_size;
+};
+
+template <typename WideNode>
+CU_GLOBAL void FillWideNodes(WideNode *wide_nodes, const AccelNode *nodes, const Bbox *bboxes,
+    const WideTask *tasks, WideTask *next_tasks, WideCounters *counters, uint32_t num_tasks) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_tasks) {
+        return;
+    }
+
+    auto task = tasks[index];
+    // each child is pushed, and each internal one is popped with the others still below it
+    uint32_t children[kAccelMaxWidth];
+    auto num_children = CollapseWideChildren(nodes, bboxes, task.binary_node, kWideNodeWidth<WideNode>, children);
+    atomicMax(&counters->max_stack_size, task.stack_size + num_children);
+    FillWideNode(wide_nodes[task.wide_node], nodes, bboxes, task.binary_node, [&](uint32_t binary_node) {
+        auto wide_node = atomicAdd(&counters->num_nodes, 1u);
+        auto next_task = atomicAdd(&counters->num_next_tasks, 1u);
+        next_tasks[next_task] = WideTask { binary_node, wide_node, task.stack_size + num_children - 1 };
+        return wide_node;
+    });
+}
+
+CU_GLOBAL void FillCompactNodes(AccelCompactNode *compact_nodes, const AccelNode *nodes, const Bbox *bboxes,
+    uint32_t num_compact_nodes) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_compact_nodes) {
+        return;
+    }
+
+    FillCompactNode(compact_nodes[index], nodes, bboxes, index);
+}
+
+// the height of a node is the most edges down to one of its leaves, the second thread arriving at a node takes
+// the higher child and continues upwards
+CU_GLOBAL void CalcNodeHeights(const AccelNode *nodes, const uint32_t *parents, uint32_t *heights, uint32_t *visits,
+    uint32_t num_leaves) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_leaves) {
+        return;
+    }
+
+    uint32_t u = num_leaves - 1 + index;
+    heights[u] = 0;
+    while (u != 0) {
+        u = parents[u];
+        __threadfence();
+        if (atomicAdd(&visits[u], 1u) == 0) {
+            return;
+        }
+        __threadfence();
+
+        heights[u] = glm::max(LoadVolatile(heights[nodes[u].lc_or_id]), LoadVolatile(heights[nodes[u].rc])) + 1;
+    }
+}
+
+// returns the most entries the traversal stack of the packed tree holds
+template <typename WideNode>
+uint32_t PackAccelWide(const AccelNode *nodes, const Bbox *bboxes, uint32_t num_leaves, WideNode *wide_nodes,
+    CuScratch &scratch) {
+    auto max_tasks = num_leaves / 2 + 1;
+    CuScratch::Scope scope(scratch);
+    auto tasks_gpu = scratch.Allocate<WideTask>(max_tasks * 2);
+    WideTask *tasks[2] = { tasks_gpu, tasks_gpu + max_tasks };
+    WideTask root_task { 0, 0, 0 };
+    cudaMemcpy(tasks_gpu, &root_task, sizeof(root_task), cudaMemcpyHostToDevice);
+
+    WideCounters counters { 1, 0, 1 };
+    auto counters_gpu = scratch.Allocate<WideCounters>(1);
+    cudaMemcpy(counters_gpu, &counters, sizeof(counters), cudaMemcpyHostToDevice);
+
+    auto threads = BlockSizeOf<FillWideNodes<WideNode>>();
+    uint32_t curr = 0;
+    uint32_t num_tasks = 1;
+    while (num_tasks > 0) {
+        cudaMemset(&counters_gpu->num_next_tasks, 0, sizeof(uint32_t));
+        FillWideNodes<WideNode><<<(num_tasks + threads - 1) / threads, threads>>>(
+            wide_nodes, nodes, bboxes, tasks[curr], tasks[curr ^ 1], counters_gpu, num_tasks);
+        curr ^= 1;
+        cudaMemcpy(&num_tasks, &counters_gpu->num_next_tasks, sizeof(uint32_t), cudaMemcpyDeviceToHost);
+    }
+    cudaMemcpy(&counters, counters_gpu, sizeof(counters), cudaMemcpyDeviceToHost);
+    return counters.max_stack_size;
+}
+
+// returns the most entries the traversal stack of the packed tree holds, which is the height of the tree since
+// at most one child is pushed per level
+uint32_t PackAccelCompact(const AccelNode *nodes, const Bbox *bboxes, uint32_t num_leaves,
+    AccelCompactNode *compact_nodes, CuScratch &scratch) {
+    auto num_compact_nodes = glm::max(num_leaves, 2u) - 1;
+    auto threads = BlockSizeOf<FillCompactNodes>();
+    FillCompactNodes<<<(num_compact_nodes + threads - 1) / threads, threads>>>(
+        compact_nodes, nodes, bboxes, num_compact_nodes);
+    if (num_leaves < 2) {
+        return 0;
+    }
+
+    auto num_nodes = 2 * num_leaves - 1;
+    CuScratch::Scope scope(scratch);
+    auto parents = scratch.Allocate<uint32_t>(num_nodes);
+    CalcAccelParents(nodes, parents, num_leaves);
+    auto heights = scratch.Allocate<uint32_t>(num_nodes);
+    auto visits = scratch.Allocate<uint32_t>(num_leaves - 1);
+    cudaMemset(visits, 0, sizeof(uint32_t) * (num_leaves - 1));
+    threads = BlockSizeOf<CalcNodeHeights>();
+    CalcNodeHeights<<<(num_leaves + threads - 1) / threads, threads>>>(nodes, parents, heights, visits, num_leaves);
+
+    uint32_t height;
+    cudaMemcpy(&height, heights, sizeof(uint32_t), cudaMemcpyDeviceToHost);
+    return height;
+}
+
+}
+
+size_t AccelPackedNodesSize(AccelLayout layout, uint32_t num_primitives) {
+    auto num_packed_nodes = glm::max(num_primitives, 2u) - 1;
+    switch (layout) {
+        case AccelLayout::eWide4:
+            return sizeof(AccelWideNode<4>) * num_packed_nodes;
+        case AccelLayout::eWide8:
+            return sizeof(AccelWideNode<8>) * num_packed_nodes;
+        case AccelLayout::eCompact:
+            return sizeof(AccelCompactNode) * num_packed_nodes;
+        case AccelLayout::eQuantized:
+            return sizeof(AccelQuantizedNode) * num_packed_nodes;
+        case AccelLayout::eStackless:
+            return sizeof(uint32_t) * (2 * num_primitives - 1);
+        default:
+            return 0;
+    }
+}
+
+size_t AccelPackScratchSize(uint32_t num_leaves, AccelLayout layout) {
+    switch (layout) {
+        case AccelLayout::eWide4:
+        case AccelLayout::eWide8:
+        case AccelLayout::eQuantized:
+            return CuScratch::PieceSize(sizeof(WideTask) * (num_leaves / 2 + 1) * 2)
+                + CuScratch::PieceSize(sizeof(WideCounters));
+        case AccelLayout::eCompact:
+            return CuScratch::PieceSize(sizeof(uint32_t) * (2 * num_leaves - 1)) * 2
+                + CuScratch::PieceSize(sizeof(uint32_t) * (num_leaves - 1));
+        default:
+            return 0;
+    }
+}
+
+AccelLayout PackAccel(const AccelNode *nodes, const Bbox *bboxes, uint32_t num_leaves, AccelLayout layout,
+    void *packed_nodes, CuScratch *scratch) {
+    uint32_t stack_size = 0;
+    auto max_stack_size = kAccelWideStackSize;
+    switch (layout) {
+        case AccelLayout::eWide4:
+            stack_size = PackAccelWide(nodes, bboxes, num_leaves, reinterpret_cast<AccelWideNode<4> *>(packed_nodes),
+                AccelScratchOrDefault(scratch));
+            break;
+        case AccelLayout::eWide8:
+            stack_size = PackAccelWide(nodes, bboxes, num_leaves, reinterpret_cast<AccelWideNode<8> *>(packed_nodes),
+                AccelScratchOrDefault(scratch));
+            break;
+        case AccelLayout::eQuantized:
+            stack_size = PackAccelWide(nodes, bboxes, num_leaves,
+                reinterpret_cast<AccelQuantizedNode *>(packed_nodes), AccelScratchOrDefault(scratch));
+            break;
+        case AccelLayout::eCompact:
+            stack_size = PackAccelCompact(nodes, bboxes, num_leaves, reinterpret_cast<AccelCompactNode *>(packed_nodes),
+                AccelScratchOrDefault(scratch));
+            max_stack_size = kAccelStackSize;
+            break;
+        case AccelLayout::eStackless:
+            CalcAccelParents(nodes, reinterpret_cast<uint32_t *>(packed_nodes), num_leaves);
+            break;
+        default:
+            break;
+    }
+    if (stack_size > max_stack_size) {
+        CalcAccelParents(nodes, reinterpret_cast<uint32_t *>(packed_nodes), num_leaves);
+        return AccelLayout::eStackless;
+    }
+    return layout;
+}
+
+}
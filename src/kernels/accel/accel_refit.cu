@@ -0,0 +1,47 @@
+#include "accel_build_common.cuh"
+
+#include <algorithm>
+
+namespace kernel {
+
+namespace {
+
+CU_GLOBAL void RefitLeafNodes(const AccelNode *nodes, Bbox *bboxes, const Bbox *primitive_bboxes,
+    const uint32_t *primitive_ids, uint32_t num_leaves) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_leaves) {
+        return;
+    }
+
+    uint32_t u = num_leaves - 1 + index;
+    bboxes[u] = RefitLeafBbox(nodes[u], primitive_bboxes, primitive_ids);
+}
+
+}
+
+size_t AccelRefitScratchSize(uint32_t num_leaves, AccelLayout layout) {
+    return std::max({
+        UpdateInternalNodesBboxScratchSize(num_leaves),
+        AccelPackScratchSize(num_leaves, layout),
+        AccelSahCostScratchSize(num_leaves),
+    });
+}
+
+AccelRefitStats RefitAccel(AccelNode *nodes, Bbox *bboxes, uint32_t *parents, const Bbox *primitive_bboxes,
+    const uint32_t *primitive_ids, uint32_t num_leaves, AccelLayout layout, void *packed_nodes, CuScratch *scratch) {
+    auto &refit_scratch = AccelScratchOrDefault(scratch);
+    CalcAccelParents(nodes, parents, num_leaves);
+    auto threads = BlockSizeOf<RefitLeafNodes>();
+    RefitLeafNodes<<<(num_leaves + threads - 1) / threads, threads>>>(
+        nodes, bboxes, primitive_bboxes, primitive_ids, num_leaves);
+    UpdateInternalNodesBbox(nodes, parents, bboxes, num_leaves, refit_scratch);
+
+    AccelRefitStats stats {};
+    if (layout != AccelLayout::eBinary) {
+        stats.layout = PackAccel(nodes, bboxes, num_leaves, layout, packed_nodes, &refit_scratch);
+    }
+    stats.sah_cost = CalcAccelSahCost(nodes, bboxes, num_leaves, &refit_scratch);
+    return stats;
+}
+
+}
@@ -0,0 +1,68 @@
+#include "accel_build_common.cuh"
+
+namespace kernel {
+
+namespace {
+
+// the second thread arriving at a node continues upwards so that both subtrees are done when a node is visited
+CU_GLOBAL void RestructureTreelets(AccelNode *nodes, Bbox *bboxes, uint32_t *parents, float *costs,
+    uint32_t *num_leaves, uint32_t *visits, uint32_t num_primitives) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_primitives) {
+        return;
+    }
+
+    uint32_t u = num_primitives - 1 + index;
+    costs[u] = SahNodeCost(nodes[u], bboxes[u]);
+    num_leaves[u] = 1;
+    while (u != 0) {
+        u = parents[u];
+        __threadfence();
+        if (atomicAdd(&visits[u], 1u) == 0) {
+            return;
+        }
+        __threadfence();
+
+        // children may have been written by the other thread, and by treelets restructured below them
+        auto lc = nodes[u].lc_or_id;
+        auto rc = nodes[u].rc;
+        num_leaves[u] = LoadVolatile(num_leaves[lc]) + LoadVolatile(num_leaves[rc]);
+        costs[u] = kSahTraversalCost * BboxHalfArea(bboxes[u]) + LoadVolatile(costs[lc]) + LoadVolatile(costs[rc]);
+        if (num_leaves[u] >= kTreeletSize) {
+            RestructureTreelet(nodes, bboxes, parents, costs, u);
+        }
+    }
+}
+
+}
+
+size_t AccelTreeletScratchSize(uint32_t num_primitives) {
+    auto num_nodes = 2 * num_primitives - 1;
+    return CuScratch::PieceSize(sizeof(uint32_t) * num_nodes) + CuScratch::PieceSize(sizeof(float) * num_nodes)
+        + CuScratch::PieceSize(sizeof(uint32_t) * num_nodes) + CuScratch::PieceSize(sizeof(uint32_t) * num_nodes);
+}
+
+void OptimizeAccelTreelets(AccelNode *nodes, Bbox *bboxes, uint32_t num_primitives, uint32_t num_passes,
+    CuScratch &scratch) {
+    if (num_primitives < 3) {
+        return;
+    }
+
+    auto num_nodes = 2 * num_primitives - 1;
+    CuScratch::Scope scope(scratch);
+    auto parents = scratch.Allocate<uint32_t>(num_nodes);
+    CalcAccelParents(nodes, parents, num_primitives);
+
+    auto costs = scratch.Allocate<float>(num_nodes);
+    auto num_leaves = scratch.Allocate<uint32_t>(num_nodes);
+    auto visits = scratch.Allocate<uint32_t>(num_primitives - 1);
+
+    auto threads = BlockSizeOf<RestructureTreelets>();
+    for (uint32_t pass = 0; pass < num_passes; pass++) {
+        cudaMemset(visits, 0, sizeof(uint32_t) * (num_primitives - 1));
+        RestructureTreelets<<<(num_primitives + threads - 1) / threads, threads>>>(
+            nodes, bboxes, parents, costs, num_leaves, visits, num_primitives);
+    }
+}
+
+}
@@ -1,33 +1,50 @@
-#pragma once
-
-#ifdef __CUDACC__
-#define CU_GLOBAL __global__
-#define CU_DEVICE __device__
-#define CU_HOST __host__
-#define CU_DEVICE_HOST __device__ __host__
-#else
-#define CU_GLOBAL
-#define CU_DEVICE
-#define CU_HOST
-#define CU_DEVICE_HOST
-#endif
-
-#include <glm/glm.hpp>
-
-namespace kernel {
-
-constexpr float kPi = 3.14159265359f;
-constexpr float k2Pi = 2.0f * kPi;
-constexpr float kInvPi = 1.0f / kPi;
-constexpr float kInv2Pi = 1.0f / k2Pi;
-
-inline CU_DEVICE float Luminance(const glm::vec3 &color) {
-    return color.r * 0.299 + color.g * 0.587 + color.b * 0.114f;
-}
-
-struct TaggedPointer {
-    uint32_t tag;
-    void *ptr;
-};
-
-}
+#pragma once
+
+#ifdef __CUDACC__
+#define CU_GLOBAL __global__
+#define CU_DEVICE __device__
+#define CU_HOST __host__
+#define CU_DEVICE_HOST __device__ __host__
+#else
+#define CU_GLOBAL
+#define CU_DEVICE
+#define CU_HOST
+#define CU_DEVICE_HOST
+#endif
+
+#include <glm/glm.hpp>
+
+namespace kernel {
+
+constexpr float kPi = 3.14159265359f;
+constexpr float k2Pi = 2.0f * kPi;
+constexpr float kInvPi = 1.0f / kPi;
+constexpr float kInv2Pi = 1.0f / k2Pi;
+
+inline CU_DEVICE float Luminance(const glm::vec3 &color) {
+    return color.r * 0.299 + color.g * 0.587 + color.b * 0.114f;
+}
+
+struct TaggedPointer {
+    uint32_t tag;
+    void *ptr;
+};
+
+#ifdef __CUDACC__
+
+// block size giving `Kernel` the highest occupancy on the device, queried on its first launch, kernels running
+// one thread per element are launched in blocks of this size
+template <auto Kernel>
+uint32_t BlockSizeOf() {
+    static const uint32_t block_size = [] {
+        int min_grid_size;
+        int size;
+        cudaOccupancyMaxPotentialBlockSize(&min_grid_size, &size, Kernel);
+        return static_cast<uint32_t>(size);
+    }();
+    return block_size;
+}
+
+#endif
+
+}
@@ -1,22 +1,30 @@
-#pragma once
-
-#include "prelude.cuh"
-
-namespace kernel {
-
-struct Ray {
-    static constexpr float kDefaultTMin = 0.0001f;
-    static constexpr float kDefaultTMax = std::numeric_limits<float>::max();
-    static constexpr float kShadowRayEps = 0.001f;
-
-    glm::vec3 origin;
-    float tmin = kDefaultTMin;
-    glm::vec3 direction;
-    float tmax = kDefaultTMax;
-
-    CU_DEVICE Ray(glm::vec3 origin, glm::vec3 direction) : origin(origin), direction(direction) {}
-
-    CU_DEVICE glm::vec3 At(float t) const { return origin + t * direction; }
-};
-
-}
+#pragma once
+
+#include "prelude.cuh"
+
+namespace kernel {
+
+struct Ray {
+    static constexpr float kDefaultTMin = 0.0001f;
+    static constexpr float kDefaultTMax = std::numeric_limits<float>::max();
+    static constexpr float kShadowRayEps = 0.001f;
+
+    glm::vec3 origin;
+    float tmin = kDefaultTMin;
+    glm::vec3 direction;
+    float tmax = kDefaultTMax;
+
+    CU_DEVICE Ray(glm::vec3 origin, glm::vec3 direction) : origin(origin), direction(direction) {}
+
+    CU_DEVICE glm::vec3 At(float t) const { return origin + t * direction; }
+};
+
+// footprint of a ray, `width` at its origin and growing by `spread` per unit distance along it
+struct RayCone {
+    float width = 0.0f;
+    float spread = 0.0f;
+
+    CU_DEVICE float WidthAt(float t) const { return width + spread * t; }
+};
+
+}
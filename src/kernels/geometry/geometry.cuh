@@ -1,42 +1,44 @@
-#pragma once
-
-#include "trimesh.cuh"
-
-namespace kernel {
-
-struct Geometry {
-    enum struct Type {
-        eTriMesh,
-    } type;
-    void *ptr;
-
-    CU_DEVICE bool Intersect(const Ray &ray, uint32_t primitive_id, float &t, glm::vec2 &attribs) const {
-        switch (type) {
-            case Type::eTriMesh:
-                return reinterpret_cast<const TriMesh *>(ptr)->Intersect(ray, primitive_id, t, attribs);
-        }
-    }
-
-    CU_DEVICE Vertex GetVertex(uint32_t primitive_id, const glm::vec2 &attribs) const {
-        switch (type) {
-            case Type::eTriMesh:
-                return reinterpret_cast<const TriMesh *>(ptr)->GetVertex(primitive_id, attribs);
-        }
-    }
-
-    CU_DEVICE Vertex SampleVertex(const glm::mat4 &transform, const glm::mat4 &transform_it,
-        const glm::vec2 &rand) const {
-        Vertex vertex {};
-        switch (type) {
-            case Type::eTriMesh:
-                vertex = reinterpret_cast<const TriMesh *>(ptr)->SampleVertex(rand);
-                break;
-        }
-        VertexTransformPdf(vertex, transform);
-        vertex.position = transform * glm::vec4(vertex.position, 1.0f);
-        vertex.normal = glm::normalize(transform_it * glm::vec4(vertex.normal, 0.0f));
-        return vertex;
-    }
-};
-
-}
+#pragma once
+
+#include "trimesh.cuh"
+
+namespace kernel {
+
+struct Geometry {
+    enum struct Type {
+        eTriMesh,
+    } type;
+    void *ptr;
+
+    // `index` is the position of the primitive in BVH leaf order
+    CU_DEVICE bool Intersect(const Ray &ray, uint32_t index, float &t, glm::vec2 &attribs,
+        uint32_t &primitive_id) const {
+        switch (type) {
+            case Type::eTriMesh:
+                return reinterpret_cast<const TriMesh *>(ptr)->Intersect(ray, index, t, attribs, primitive_id);
+        }
+    }
+
+    CU_DEVICE Vertex GetVertex(uint32_t primitive_id, const glm::vec2 &attribs) const {
+        switch (type) {
+            case Type::eTriMesh:
+                return reinterpret_cast<const TriMesh *>(ptr)->GetVertex(primitive_id, attribs);
+        }
+    }
+
+    CU_DEVICE Vertex SampleVertex(const glm::mat4x3 &transform, const glm::mat3 &normal_matrix,
+        const glm::vec2 &rand) const {
+        Vertex vertex {};
+        switch (type) {
+            case Type::eTriMesh:
+                vertex = reinterpret_cast<const TriMesh *>(ptr)->SampleVertex(rand);
+                break;
+        }
+        VertexTransformPdf(vertex, glm::mat3(transform));
+        vertex.position = transform * glm::vec4(vertex.position, 1.0f);
+        vertex.normal = glm::normalize(normal_matrix * vertex.normal);
+        return vertex;
+    }
+};
+
+}
@@ -0,0 +1,40 @@
+#include "trimesh.cuh"
+
+namespace kernel {
+
+namespace {
+
+CU_GLOBAL void BuildTrianglesKernel(TriMeshTriangle *triangles, TriMesh mesh, const uint32_t *primitive_ids,
+    uint32_t num_triangles) {
+    uint32_t index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index >= num_triangles) {
+        return;
+    }
+
+    auto primitive_id = primitive_ids[index];
+    auto p0 = mesh.GetPosition(mesh.indices[primitive_id * 3]);
+    auto p1 = mesh.GetPosition(mesh.indices[primitive_id * 3 + 1]);
+    auto p2 = mesh.GetPosition(mesh.indices[primitive_id * 3 + 2]);
+    triangles[index] = TriMeshTriangle {
+        .p0 = p0,
+        .primitive_id = primitive_id,
+        .e1 = p1 - p0,
+        .padding0 = 0.0f,
+        .e2 = p2 - p0,
+        .padding1 = 0.0f,
+    };
+}
+
+}
+
+void TriMesh::BuildTriangles(TriMeshTriangle *triangles, const TriMesh &mesh, const uint32_t *primitive_ids,
+    uint32_t num_triangles) {
+    if (num_triangles == 0) {
+        return;
+    }
+    auto threads = BlockSizeOf<BuildTrianglesKernel>();
+    BuildTrianglesKernel<<<(num_triangles + threads - 1) / threads, threads>>>(
+        triangles, mesh, primitive_ids, num_triangles);
+}
+
+}
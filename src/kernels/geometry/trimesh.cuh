@@ -1,83 +1,174 @@
-#pragma once
-
-#include "common.cuh"
-
-namespace kernel {
-
-struct TriMesh {
-    glm::vec3 *positions;
-    glm::vec3 *normals;
-    glm::vec2 *texcoords;
-    uint32_t *indices;
-    uint32_t num_triangles;
-
-    CU_DEVICE bool Intersect(const Ray &ray, uint32_t primitive_id, float &t, glm::vec2 &attribs) const {
-        auto i0 = indices[primitive_id * 3];
-        auto i1 = indices[primitive_id * 3 + 1];
-        auto i2 = indices[primitive_id * 3 + 2];
-        auto p0 = positions[i0];
-        auto p1 = positions[i1];
-        auto p2 = positions[i2];
-        auto e1 = p1 - p0;
-        auto e2 = p2 - p0;
-        auto q = glm::cross(ray.direction, e2);
-        auto det = glm::dot(e1, q);
-        if (det != 0.0f) {
-            det = 1.0f / det;
-            auto s = ray.origin - p0;
-            auto v = glm::dot(s, q) * det;
-            if (v >= 0.0f) {
-                auto r = glm::cross(s, e1);
-                auto w = glm::dot(ray.direction, r) * det;
-                auto u = 1.0f - v - w;
-                if (w >= 0.0f && u >= 0.0f) {
-                    t = glm::dot(e2, r) * det;
-                    if (t > ray.tmin && t < ray.tmax) {
-                        attribs = glm::vec2(v, w);
-                        return true;
-                    }
-                }
-            }
-        }
-        return false;
-    }
-
-    CU_DEVICE Vertex GetVertex(uint32_t primitive_id, const glm::vec2 &attribs) const {
-        auto i0 = indices[primitive_id * 3];
-        auto i1 = indices[primitive_id * 3 + 1];
-        auto i2 = indices[primitive_id * 3 + 2];
-
-        Vertex vert {};
-
-        auto pos0 = positions[i0];
-        auto pos1 = positions[i1];
-        auto pos2 = positions[i2];
-        auto e1 = pos1 - pos0;
-        auto e2 = pos2 - pos0;
-        auto area = glm::length(glm::cross(e1, e2)) * 0.5f;
-        vert.pdf = 1.0f / area / num_triangles;
-        vert.position = pos0 + attribs.x * (pos1 - pos0) + attribs.y * (pos2 - pos0);
-
-        auto norm0 = normals[i0];
-        auto norm1 = normals[i1];
-        auto norm2 = normals[i2];
-        vert.normal = glm::normalize(norm0 + attribs.x * (norm1 - norm0) + attribs.y * (norm2 - norm0));
-
-        auto tc0 = texcoords[i0];
-        auto tc1 = texcoords[i1];
-        auto tc2 = texcoords[i2];
-        vert.texcoord = tc0 + attribs.x * (tc1 - tc0) + attribs.y * (tc2 - tc0);
-
-        return vert;
-    }
-
-    CU_DEVICE Vertex SampleVertex(const glm::vec2 &rand) const {
-        auto primitive_id = glm::min(static_cast<uint32_t>(rand.x * num_triangles), num_triangles - 1);
-        float u_sqrt = sqrt(rand.x * num_triangles - primitive_id);
-        float u = 1.0f - u_sqrt;
-        float v = (1.0f - rand.y) * u_sqrt;
-        return GetVertex(primitive_id, glm::vec2(u, v));
-    }
-};
-
-}
+#pragma once
+
+#include <glm/gtc/type_precision.hpp>
+
+#include "common.cuh"
+
+namespace kernel {
+
+inline CU_DEVICE_HOST glm::vec2 EncodeOctahedral(const glm::vec3 &dir) {
+    auto p = glm::vec2(dir) / (glm::abs(dir.x) + glm::abs(dir.y) + glm::abs(dir.z));
+    if (dir.z < 0.0f) {
+        auto sign = glm::vec2(p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f);
+        p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * sign;
+    }
+    return p;
+}
+
+inline CU_DEVICE_HOST glm::vec3 DecodeOctahedral(const glm::vec2 &p) {
+    glm::vec3 dir(p, 1.0f - glm::abs(p.x) - glm::abs(p.y));
+    if (dir.z < 0.0f) {
+        auto sign = glm::vec2(p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f);
+        dir.x = (1.0f - glm::abs(p.y)) * sign.x;
+        dir.y = (1.0f - glm::abs(p.x)) * sign.y;
+    }
+    return glm::normalize(dir);
+}
+
+// 16 bytes instead of 32, see `TriMesh::compressed_vertices`
+struct alignas(16) TriMeshCompressedVertex {
+    // `position_offset + position * position_scale` of the mesh
+    glm::u16vec3 position;
+    uint16_t padding;
+    // octahedral encoded in snorm16
+    uint32_t normal;
+    // half floats
+    uint32_t texcoord;
+};
+
+// `scale` should be a power of 2 so that decoding is exact with or without fused multiply-add,
+// and the positions BVHs are built from are the same on the host and the device
+inline CU_DEVICE_HOST glm::vec3 DecodePosition(const glm::u16vec3 &position, const glm::vec3 &offset,
+    const glm::vec3 &scale) {
+    return offset + glm::vec3(position) * scale;
+}
+
+// a triangle prepared for intersection, `primitive_id` is its index in the mesh
+struct alignas(16) TriMeshTriangle {
+    glm::vec3 p0;
+    uint32_t primitive_id;
+    glm::vec3 e1;
+    float padding0;
+    glm::vec3 e2;
+    float padding1;
+};
+
+struct TriMesh {
+    glm::vec3 *positions;
+    glm::vec3 *normals;
+    glm::vec2 *texcoords;
+    // used instead of `positions`, `normals` and `texcoords` if not null
+    TriMeshCompressedVertex *compressed_vertices;
+    glm::vec3 position_offset;
+    glm::vec3 position_scale;
+    uint32_t *indices;
+    // in BVH leaf order, only used for intersection, null if triangles are decoded from `compressed_vertices`
+    // when intersected, which saves the 48 bytes a triangle takes for the 16 bytes a vertex takes
+    TriMeshTriangle *triangles;
+    // in BVH leaf order, used to find the triangles to decode if `triangles` is null
+    uint32_t *primitive_ids;
+    uint32_t num_triangles;
+
+    // `index` is the position of the triangle in BVH leaf order
+    CU_DEVICE bool Intersect(const Ray &ray, uint32_t index, float &t, glm::vec2 &attribs,
+        uint32_t &primitive_id) const {
+        glm::vec3 p0, e1, e2;
+        if (triangles) {
+            const auto &tri = triangles[index];
+            primitive_id = tri.primitive_id;
+            p0 = tri.p0;
+            e1 = tri.e1;
+            e2 = tri.e2;
+        } else {
+            // same as `BuildTriangles` computes
+            primitive_id = primitive_ids[index];
+            p0 = GetPosition(indices[primitive_id * 3]);
+            e1 = GetPosition(indices[primitive_id * 3 + 1]) - p0;
+            e2 = GetPosition(indices[primitive_id * 3 + 2]) - p0;
+        }
+        auto q = glm::cross(ray.direction, e2);
+        auto det = glm::dot(e1, q);
+        if (det != 0.0f) {
+            det = 1.0f / det;
+            auto s = ray.origin - p0;
+            auto v = glm::dot(s, q) * det;
+            if (v >= 0.0f) {
+                auto r = glm::cross(s, e1);
+                auto w = glm::dot(ray.direction, r) * det;
+                auto u = 1.0f - v - w;
+                if (w >= 0.0f && u >= 0.0f) {
+                    t = glm::dot(e2, r) * det;
+                    if (t > ray.tmin && t < ray.tmax) {
+                        attribs = glm::vec2(v, w);
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    CU_DEVICE_HOST glm::vec3 GetPosition(uint32_t index) const {
+        if (compressed_vertices) {
+            return DecodePosition(compressed_vertices[index].position, position_offset, position_scale);
+        }
+        return positions[index];
+    }
+
+    CU_DEVICE glm::vec3 GetNormal(uint32_t index) const {
+        if (compressed_vertices) {
+            return DecodeOctahedral(glm::unpackSnorm2x16(compressed_vertices[index].normal));
+        }
+        return normals[index];
+    }
+
+    CU_DEVICE glm::vec2 GetTexcoord(uint32_t index) const {
+        if (compressed_vertices) {
+            return glm::unpackHalf2x16(compressed_vertices[index].texcoord);
+        }
+        return texcoords[index];
+    }
+
+    CU_DEVICE Vertex GetVertex(uint32_t primitive_id, const glm::vec2 &attribs) const {
+        auto i0 = indices[primitive_id * 3];
+        auto i1 = indices[primitive_id * 3 + 1];
+        auto i2 = indices[primitive_id * 3 + 2];
+
+        Vertex vert {};
+
+        auto pos0 = GetPosition(i0);
+        auto pos1 = GetPosition(i1);
+        auto pos2 = GetPosition(i2);
+        auto e1 = pos1 - pos0;
+        auto e2 = pos2 - pos0;
+        auto area = glm::length(glm::cross(e1, e2)) * 0.5f;
+        vert.pdf = 1.0f / area / num_triangles;
+        vert.position = pos0 + attribs.x * (pos1 - pos0) + attribs.y * (pos2 - pos0);
+
+        auto norm0 = GetNormal(i0);
+        auto norm1 = GetNormal(i1);
+        auto norm2 = GetNormal(i2);
+        vert.normal = glm::normalize(norm0 + attribs.x * (norm1 - norm0) + attribs.y * (norm2 - norm0));
+
+        auto tc0 = GetTexcoord(i0);
+        auto tc1 = GetTexcoord(i1);
+        auto tc2 = GetTexcoord(i2);
+        vert.texcoord = tc0 + attribs.x * (tc1 - tc0) + attribs.y * (tc2 - tc0);
+
+        return vert;
+    }
+
+    CU_DEVICE Vertex SampleVertex(const glm::vec2 &rand) const {
+        auto primitive_id = glm::min(static_cast<uint32_t>(rand.x * num_triangles), num_triangles - 1);
+        float u_sqrt = sqrt(rand.x * num_triangles - primitive_id);
+        float u = 1.0f - u_sqrt;
+        float v = (1.0f - rand.y) * u_sqrt;
+        return GetVertex(primitive_id, glm::vec2(u, v));
+    }
+
+    // fills `triangles` with the triangles `primitive_ids` of `mesh` in order
+    static void BuildTriangles(TriMeshTriangle *triangles, const TriMesh &mesh, const uint32_t *primitive_ids,
+        uint32_t num_triangles);
+};
+
+}
@@ -1,25 +1,29 @@
-#pragma once
-
-#include "../scene/scene.cuh"
-
-namespace kernel {
-
-struct PathTracer {
-    struct Params {
-        Scene scene;
-        glm::vec4 *output;
-        uint32_t screen_width;
-        uint32_t screen_height;
-        uint32_t spp;
-        uint32_t max_depth;
-
-        enum struct Channel {
-            eColor,
-            eNormal,
-        } channel;
-    };
-
-    static void Render(const Params &params);
-};
-
-}
+#pragma once
+
+#include "../scene/scene.cuh"
+
+namespace kernel {
+
+struct PathTracer {
+    struct Params {
+        Scene scene;
+        glm::vec4 *output;
+        // shadow rays of a pixel test the last primitive that blocked one of them first
+        AccelOccluder *occluders;
+        // angle covered by a pixel, which widens the ray cones selecting levels of detail, 0 to disable them
+        float lod_spread;
+        uint32_t screen_width;
+        uint32_t screen_height;
+        uint32_t spp;
+        uint32_t max_depth;
+
+        enum struct Channel {
+            eColor,
+            eNormal,
+        } channel;
+    };
+
+    static void Render(const Params &params);
+};
+
+}
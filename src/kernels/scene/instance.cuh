@@ -1,29 +1,39 @@
-#pragma once
-
-#include "../accel/accel.cuh"
-#include "../material/material.cuh"
-#include "../light/light.cuh"
-
-namespace kernel {
-
-struct ShadingSurface {
-    Vertex vertex;
-    Bsdf bsdf;
-};
-
-struct Instance {
-    Geometry geometry;
-    Material material;
-    Light light;
-
-    CU_DEVICE ShadingSurface GetShadingSurface(const AccelHitInfo &hit_info) const {
-        auto transform_it = glm::transpose(hit_info.transform_inv);
-        auto vertex = geometry.GetVertex(hit_info.primitive_id, hit_info.attribs);
-        VertexTransformPdf(vertex, hit_info.transform);
-        vertex.position = hit_info.transform * glm::vec4(vertex.position, 1.0f);
-        vertex.normal = glm::normalize(transform_it * glm::vec4(vertex.normal, 0.0f));
-        return ShadingSurface { vertex, material.GetBsdf(vertex.texcoord )};
-    }
-};
-
-}
+#pragma once
+
+#include "../accel/accel.cuh"
+#include "../material/material.cuh"
+#include "../light/light.cuh"
+
+namespace kernel {
+
+struct ShadingSurface {
+    Vertex vertex;
+    Bsdf bsdf;
+};
+
+struct Instance {
+    Geometry geometry;
+    Material material;
+    Light light;
+    // affine, object to world
+    glm::mat4x3 transform;
+    // inverse transpose of the linear part of `transform`
+    glm::mat3 normal_matrix;
+    // per triangle materials of geometry merged from several objects, `material` is used if null
+    Material *materials;
+    uint32_t *material_ids;
+    // same as `AccelTop::Instance::lods`, whose geometry is shaded when a coarser level of detail is hit
+    AccelBottom **lods;
+
+    CU_DEVICE ShadingSurface GetShadingSurface(const AccelHitInfo &hit_info) const {
+        const auto &hit_geometry = hit_info.lod == 0 ? geometry : lods[hit_info.lod - 1]->geometry;
+        auto vertex = hit_geometry.GetVertex(hit_info.primitive_id, hit_info.attribs);
+        VertexTransformPdf(vertex, glm::mat3(transform));
+        vertex.position = transform * glm::vec4(vertex.position, 1.0f);
+        vertex.normal = glm::normalize(normal_matrix * vertex.normal);
+        const auto &mat = material_ids ? materials[material_ids[hit_info.primitive_id]] : material;
+        return ShadingSurface { vertex, mat.GetBsdf(vertex.texcoord )};
+    }
+};
+
+}
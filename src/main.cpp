@@ -1,134 +1,253 @@
-#include <iostream>
-
-#include "scene/loader.hpp"
-#include "scene/camera.hpp"
-#include "window/window.hpp"
-#include "pathtracer/pathtracer.hpp"
-
-int main(int argc, char **argv) {
-    struct {
-        bool ui = true;
-        int max_depth = -1;
-        int max_spp = -1;
-        const char *capture_name = "capture";
-        const char *bsdf_type = "blinn-phong";
-        int bsdf_type_i = 2;
-    } cmd_args;
-
-    if (argc < 3) {
-        std::cout << "usage: " << argv[0] << " <path-to-obj-file> <path-to-extra-file> [OPTIONS]\n";
-        std::cout << "\nOPTIONS\n";
-        std::cout << "  --ui            0 or 1, whether show UI (default 1)\n";
-        std::cout << "  --max-depth     max ray tracing depth (default -1, no limit)\n";
-        std::cout << "  --max-spp       max ray tracing spp when ui is 0 (default -1, no limit)\n";
-        std::cout << "  --output | -o   output .exr name (default 'capture')\n";
-        std::cout << "  --bsdf-type     which BSDF to use (default 'blinn-phong')\n";
-        return -1;
-    }
-    for (int i = 3; i < argc; i++) {
-        if (strcmp(argv[i], "--ui") == 0) {
-            cmd_args.ui = std::atoi(argv[++i]);
-        } else if (strcmp(argv[i], "--max-depth") == 0) {
-            cmd_args.max_depth = std::atoi(argv[++i]);
-        } else if (strcmp(argv[i], "--max-spp") == 0) {
-            cmd_args.max_spp = std::atoi(argv[++i]);
-        } else if (strcmp(argv[i], "--output") == 0 || strcmp(argv[i], "-o") == 0) {
-            cmd_args.capture_name = argv[++i];
-        } else if (strcmp(argv[i], "--bsdf-type") == 0) {
-            cmd_args.bsdf_type = argv[++i];
-        }
-    }
-    const char *bsdf_type_names[] = {
-        "lambert", "phong", "blinn-phong", "microfacet"
-    };
-    for (int i = 0; i < 4; i++) {
-        if (strcmp(cmd_args.bsdf_type, bsdf_type_names[i]) == 0) {
-            cmd_args.bsdf_type_i = i;
-        }
-    }
-
-    std::filesystem::path obj_path(argv[1]);
-    if (!std::filesystem::exists(obj_path)) {
-        std::cout << "obj file '" << obj_path << "' doesn't exist" << std::endl;
-        return -1;
-    }
-
-    std::filesystem::path extra_path(argv[2]);
-    if (!std::filesystem::exists(extra_path)) {
-        std::cout << "extra file '" << extra_path << "' doesn't exist" << std::endl;
-        return -1;
-    }
-
-    Scene scene {};
-    if (!LoadObjScene(scene, obj_path, cmd_args.bsdf_type_i)) {
-        std::cout << "failed to load obj file '" << obj_path << "'" << std::endl;
-        return -1;
-    }
-    if (extra_path.extension() == ".json") {
-        if (!LoadJsonScene(scene, extra_path)) {
-            std::cout << "failed to load json file '" << extra_path << "'" << std::endl;
-            return -1;
-        }
-    } else if (extra_path.extension() == ".xml") {
-        if (!LoadXmlScene(scene, extra_path)) {
-            std::cout << "failed to load xml file '" << extra_path << "'" << std::endl;
-            return -1;
-        }
-    } else {
-        std::cout << "unknown extra file extension '" << extra_path.extension().string() << "'" << std::endl;
-        return -1;
-    }
-
-    uint32_t window_width = 1280;
-    uint32_t window_height = 720;
-    Window window(window_width, window_height, "CUDA pathtracer", !cmd_args.ui);
-
-    auto camera_object = scene.FirstObjectWith<CameraComponent>();
-    uint32_t film_width = window_width;
-    uint32_t film_height = window_height;
-    if (!cmd_args.ui) {
-        auto camera_comp = camera_object->GetComponent<CameraComponent>();
-        film_width = camera_comp->film_width;
-        film_height = camera_comp->film_height;
-    }
-    Film film(film_width, film_height);
-
-    auto path_tracer = camera_object->AddComponent<PathTracer>(scene, film);
-    path_tracer->SetMaxDepth(cmd_args.max_depth);
-    path_tracer->SetCaptureName(cmd_args.capture_name);
-    path_tracer->BuildBuffers();
-
-    if (cmd_args.ui) {
-        window.SetResizeCallback([&](uint32_t width, uint32_t height) {
-            window_width = width;
-            window_height = height;
-            film.Resize(width, height);
-        });
-
-        window.MainLoop([&]() {
-            scene.Update();
-
-            window.Display(film.GlTexture());
-
-            if (ImGui::Begin("Status")) {
-                float fps = ImGui::GetIO().Framerate;
-                ImGui::Text("%.3f ms/frame (%.1f FPS)", 1000.0f / fps, fps);
-            }
-            ImGui::End();
-
-            scene.ShowUi();
-        });
-    } else {
-        uint32_t max_spp = std::min(static_cast<uint32_t>(cmd_args.max_spp), 65536u);
-        for (uint32_t i = 0; i < max_spp; i++) {
-            scene.Update();
-            if ((i + 1) % 16 == 0) {
-                std::cout << "spp " << i + 1 << std::endl;
-            }
-        }
-        auto exr_name = std::string(cmd_args.capture_name) + ".exr";
-        film.SaveTo(exr_name.c_str());
-    }
-
-    return 0;
-}
+#include <iostream>
+
+#include "scene/loader.hpp"
+#include "scene/camera.hpp"
+#include "scene/mesh.hpp"
+#include "window/window.hpp"
+#include "pathtracer/pathtracer.hpp"
+
+int main(int argc, char **argv) {
+    struct {
+        bool ui = true;
+        int max_depth = -1;
+        int max_spp = -1;
+        const char *capture_name = "capture";
+        const char *bsdf_type = "blinn-phong";
+        int bsdf_type_i = 2;
+        const char *accel_builder = "lbvh";
+        const char *top_accel_builder = "lbvh";
+        const char *accel_layout = "binary";
+        const char *top_accel_layout = "binary";
+        int treelet_passes = 0;
+        int max_leaf_size = 1;
+        float sbvh_growth = 0.5f;
+        const char *accel_cache_dir = "";
+        const char *accel_report_path = "";
+        bool compress_vertices = false;
+        int merge_max_triangles = 0;
+        int lod_levels = 0;
+    } cmd_args;
+
+    if (argc < 3) {
+        std::cout << "usage: " << argv[0] << " <path-to-obj-file> <path-to-extra-file> [OPTIONS]\n";
+        std::cout << "\nOPTIONS\n";
+        std::cout << "  --ui            0 or 1, whether show UI (default 1)\n";
+        std::cout << "  --max-depth     max ray tracing depth (default -1, no limit)\n";
+        std::cout << "  --max-spp       max ray tracing spp when ui is 0 (default -1, no limit)\n";
+        std::cout << "  --output | -o   output .exr name (default 'capture')\n";
+        std::cout << "  --bsdf-type     which BSDF to use (default 'blinn-phong')\n";
+        std::cout << "  --accel-builder      BVH builder of meshes, 'lbvh', 'sah', 'ploc' or 'sbvh' (default 'lbvh')\n";
+        std::cout << "  --top-accel-builder  BVH builder of instances, 'lbvh', 'sah' or 'ploc' (default 'lbvh')\n";
+        std::cout << "  --accel-layout       BVH layout of meshes, 'binary', 'wide4', 'wide8', 'compact',\n";
+        std::cout << "                       'stackless' or 'quantized' (default binary)\n";
+        std::cout << "  --top-accel-layout   BVH layout of instances, see above (default 'binary')\n";
+        std::cout << "  --treelet-passes     BVH treelet restructuring passes of both levels (default 0)\n";
+        std::cout << "  --max-leaf-size      max primitives per BVH leaf of both levels, at most 8 (default 1)\n";
+        std::cout << "  --sbvh-growth        max extra triangle references of 'sbvh' relative to triangles (default 0.5)\n";
+        std::cout << "  --accel-cache        directory to cache BVHs of meshes in (default none)\n";
+        std::cout << "  --accel-report       .json file to write BVH quality statistics to (default none)\n";
+        std::cout << "  --compress-vertices  0 or 1, whether store mesh vertices quantized in 16 bytes (default 0)\n";
+        std::cout << "  --merge-meshes       merge static meshes of at most this many triangles sharing a transform\n";
+        std::cout << "                       into one mesh (default 0, disabled)\n";
+        std::cout << "  --lod-levels         coarser levels of detail made for each mesh, picked per ray by its\n";
+        std::cout << "                       footprint (default 0, disabled)\n";
+        return -1;
+    }
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--ui") == 0) {
+            cmd_args.ui = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-depth") == 0) {
+            cmd_args.max_depth = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-spp") == 0) {
+            cmd_args.max_spp = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--output") == 0 || strcmp(argv[i], "-o") == 0) {
+            cmd_args.capture_name = argv[++i];
+        } else if (strcmp(argv[i], "--bsdf-type") == 0) {
+            cmd_args.bsdf_type = argv[++i];
+        } else if (strcmp(argv[i], "--accel-builder") == 0) {
+            cmd_args.accel_builder = argv[++i];
+        } else if (strcmp(argv[i], "--top-accel-builder") == 0) {
+            cmd_args.top_accel_builder = argv[++i];
+        } else if (strcmp(argv[i], "--accel-layout") == 0) {
+            cmd_args.accel_layout = argv[++i];
+        } else if (strcmp(argv[i], "--top-accel-layout") == 0) {
+            cmd_args.top_accel_layout = argv[++i];
+        } else if (strcmp(argv[i], "--treelet-passes") == 0) {
+            cmd_args.treelet_passes = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-leaf-size") == 0) {
+            cmd_args.max_leaf_size = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sbvh-growth") == 0) {
+            cmd_args.sbvh_growth = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--accel-cache") == 0) {
+            cmd_args.accel_cache_dir = argv[++i];
+        } else if (strcmp(argv[i], "--accel-report") == 0) {
+            cmd_args.accel_report_path = argv[++i];
+        } else if (strcmp(argv[i], "--compress-vertices") == 0) {
+            cmd_args.compress_vertices = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--merge-meshes") == 0) {
+            cmd_args.merge_max_triangles = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--lod-levels") == 0) {
+            cmd_args.lod_levels = std::atoi(argv[++i]);
+        }
+    }
+    const char *bsdf_type_names[] = {
+        "lambert", "phong", "blinn-phong", "microfacet"
+    };
+    for (int i = 0; i < 4; i++) {
+        if (strcmp(cmd_args.bsdf_type, bsdf_type_names[i]) == 0) {
+            cmd_args.bsdf_type_i = i;
+        }
+    }
+    auto parse_accel_options = [&cmd_args](const char *builder, const char *layout) {
+        kernel::AccelBuildOptions options {};
+        options.num_treelet_passes = std::max(cmd_args.treelet_passes, 0);
+        options.max_leaf_size = std::max(cmd_args.max_leaf_size, 1);
+        options.max_spatial_split_growth = std::max(cmd_args.sbvh_growth, 0.0f);
+        if (strcmp(builder, "sah") == 0) {
+            options.builder = kernel::AccelBuilder::eSah;
+        } else if (strcmp(builder, "ploc") == 0) {
+            options.builder = kernel::AccelBuilder::ePloc;
+        } else if (strcmp(builder, "sbvh") == 0) {
+            options.builder = kernel::AccelBuilder::eSbvh;
+        }
+        if (strcmp(layout, "wide4") == 0) {
+            options.layout = kernel::AccelLayout::eWide4;
+        } else if (strcmp(layout, "wide8") == 0) {
+            options.layout = kernel::AccelLayout::eWide8;
+        } else if (strcmp(layout, "compact") == 0) {
+            options.layout = kernel::AccelLayout::eCompact;
+        } else if (strcmp(layout, "stackless") == 0) {
+            options.layout = kernel::AccelLayout::eStackless;
+        } else if (strcmp(layout, "quantized") == 0) {
+            options.layout = kernel::AccelLayout::eQuantized;
+        }
+        return options;
+    };
+    auto accel_options = parse_accel_options(cmd_args.accel_builder, cmd_args.accel_layout);
+    auto top_accel_options = parse_accel_options(cmd_args.top_accel_builder, cmd_args.top_accel_layout);
+
+    std::filesystem::path obj_path(argv[1]);
+    if (!std::filesystem::exists(obj_path)) {
+        std::cout << "obj file '" << obj_path << "' doesn't exist" << std::endl;
+        return -1;
+    }
+
+    std::filesystem::path extra_path(argv[2]);
+    if (!std::filesystem::exists(extra_path)) {
+        std::cout << "extra file '" << extra_path << "' doesn't exist" << std::endl;
+        return -1;
+    }
+
+    Scene scene {};
+    if (!LoadObjScene(scene, obj_path, cmd_args.bsdf_type_i)) {
+        std::cout << "failed to load obj file '" << obj_path << "'" << std::endl;
+        return -1;
+    }
+    if (extra_path.extension() == ".json") {
+        if (!LoadJsonScene(scene, extra_path)) {
+            std::cout << "failed to load json file '" << extra_path << "'" << std::endl;
+            return -1;
+        }
+    } else if (extra_path.extension() == ".xml") {
+        if (!LoadXmlScene(scene, extra_path)) {
+            std::cout << "failed to load xml file '" << extra_path << "'" << std::endl;
+            return -1;
+        }
+    } else {
+        std::cout << "unknown extra file extension '" << extra_path.extension().string() << "'" << std::endl;
+        return -1;
+    }
+    scene.ForEach<MeshComponent>([&accel_options, &cmd_args](MeshComponent &mesh) {
+        mesh.GetMesh()->SetAccelOptions(accel_options);
+        mesh.GetMesh()->SetAccelCacheDir(cmd_args.accel_cache_dir);
+        mesh.GetMesh()->SetCompressVertices(cmd_args.compress_vertices);
+    });
+
+    uint32_t window_width = 1280;
+    uint32_t window_height = 720;
+    Window window(window_width, window_height, "CUDA pathtracer", !cmd_args.ui);
+
+    auto camera_object = scene.FirstObjectWith<CameraComponent>();
+    uint32_t film_width = window_width;
+    uint32_t film_height = window_height;
+    if (!cmd_args.ui) {
+        auto camera_comp = camera_object->GetComponent<CameraComponent>();
+        film_width = camera_comp->film_width;
+        film_height = camera_comp->film_height;
+    }
+    Film film(film_width, film_height);
+
+    auto path_tracer = camera_object->AddComponent<PathTracer>(scene, film);
+    path_tracer->SetMaxDepth(cmd_args.max_depth);
+    path_tracer->SetCaptureName(cmd_args.capture_name);
+    path_tracer->SetTopAccelOptions(top_accel_options);
+    path_tracer->SetMergeMaxTriangles(std::max(cmd_args.merge_max_triangles, 0));
+    path_tracer->SetLodLevels(std::max(cmd_args.lod_levels, 0));
+    path_tracer->BuildBuffers();
+
+    if (strcmp(cmd_args.accel_builder, "sbvh") == 0) {
+        size_t num_references = 0;
+        size_t num_triangles = 0;
+        for (auto mesh : path_tracer->RenderedMeshes()) {
+            num_references += mesh->AccelStats().num_references;
+            num_triangles += mesh->IndicesCount() / 3;
+        }
+        std::cout << "mesh BVH references: " << num_references << " of " << num_triangles << " triangles"
+            << std::endl;
+    }
+    if (cmd_args.treelet_passes > 0 || cmd_args.max_leaf_size > 1) {
+        float initial_sah_cost = 0.0f;
+        float sah_cost = 0.0f;
+        size_t num_triangles = 0;
+        for (auto mesh : path_tracer->RenderedMeshes()) {
+            auto count = mesh->IndicesCount() / 3;
+            initial_sah_cost += mesh->AccelStats().initial_sah_cost * count;
+            sah_cost += mesh->AccelStats().sah_cost * count;
+            num_triangles += count;
+        }
+        if (num_triangles > 0) {
+            std::cout << "mesh BVH SAH cost (triangle weighted): " << initial_sah_cost / num_triangles
+                << " -> " << sah_cost / num_triangles << std::endl;
+        }
+        const auto &top_stats = path_tracer->TopAccelStats();
+        std::cout << "instance BVH SAH cost: " << top_stats.initial_sah_cost << " -> " << top_stats.sah_cost
+            << std::endl;
+    }
+    if (cmd_args.accel_report_path[0] != '\0' && !path_tracer->WriteAccelReport(cmd_args.accel_report_path)) {
+        std::cout << "failed to write BVH report '" << cmd_args.accel_report_path << "'" << std::endl;
+    }
+
+    if (cmd_args.ui) {
+        window.SetResizeCallback([&](uint32_t width, uint32_t height) {
+            window_width = width;
+            window_height = height;
+            film.Resize(width, height);
+        });
+
+        window.MainLoop([&]() {
+            scene.Update();
+
+            window.Display(film.GlTexture());
+
+            if (ImGui::Begin("Status")) {
+                float fps = ImGui::GetIO().Framerate;
+                ImGui::Text("%.3f ms/frame (%.1f FPS)", 1000.0f / fps, fps);
+            }
+            ImGui::End();
+
+            scene.ShowUi();
+        });
+    } else {
+        uint32_t max_spp = std::min(static_cast<uint32_t>(cmd_args.max_spp), 65536u);
+        for (uint32_t i = 0; i < max_spp; i++) {
+            scene.Update();
+            if ((i + 1) % 16 == 0) {
+                std::cout << "spp " << i + 1 << std::endl;
+            }
+        }
+        auto exr_name = std::string(cmd_args.capture_name) + ".exr";
+        film.SaveTo(exr_name.c_str());
+    }
+
+    return 0;
+}
@@ -1,221 +1,694 @@
-#include "pathtracer.hpp"
-
-#include <format>
-
-#include <imgui.h>
-
-#include "scene/mesh.hpp"
-#include "scene/material.hpp"
-#include "scene/camera.hpp"
-#include "kernels/accel/accel_build.cuh"
-#include "kernels/integrator/path.cuh"
-
-PathTracer::PathTracer(Scene &scene, Film &film) : scene_(scene), film_(film) {}
-
-void PathTracer::BuildBuffers() {
-    BuildAccel();
-
-    scene_.ForEach<CameraComponent>([this](CameraComponent &camera) {
-        camera.BuildBuffer();
-        camera_buffer_ = camera.Buffer();
-    });
-
-    BuildInstancesAndLights();
-}
-
-void PathTracer::Update() {
-    if (!camera_buffer_ || num_lights_ == 0) {
-        return;
-    }
-
-    if (film_.Width() != last_width_ || film_.Height() != last_height_) {
-        ResetAccumelation();
-        last_width_ = film_.Width();
-        last_height_ = film_.Height();
-    }
-
-    ++curr_spp_;
-    kernel::PathTracer::Params params {
-        .scene = {
-            .camera = {
-                .type = kernel::Camera::Type::ePinhole,
-                .ptr = camera_buffer_->GpuData(),
-            },
-            .light_sampler = {
-                .lights = lights_buffer_->TypedGpuData<kernel::Light>(),
-                .num_lights = num_lights_,
-                .pdf = num_lights_ != 0 ? 1.0f / num_lights_ : 0.0f,
-            },
-            .instances = instances_buffer_->TypedGpuData<kernel::Instance>(),
-            .accel = accel_buffer_->TypedGpuData<kernel::AccelTop>(),
-        },
-        .output = film_.CudaMap(),
-        .screen_width = film_.Width(),
-        .screen_height = film_.Height(),
-        .spp = curr_spp_,
-        .max_depth = static_cast<uint32_t>(max_depth_),
-        .channel = static_cast<kernel::PathTracer::Params::Channel>(display_channel_),
-    };
-    kernel::PathTracer::Render(params);
-    film_.CudaUnmap();
-}
-
-void PathTracer::ShowUi() {
-    bool changed = false;
-    changed |= ImGui::DragInt("max depth", &max_depth_, 1, -1, 16);
-    ImGui::Text("accumelated spp: %u", curr_spp_);
-    changed |= ImGui::Button("reset accumeltaion");
-
-    const char *channel_name[] = {
-        "Color",
-        "Normal",
-    };
-    changed |= ImGui::Combo("channel", &display_channel_, channel_name,
-        sizeof(channel_name) / sizeof(channel_name[0]));
-
-    if (ImGui::Button("capture frame")) {
-        auto exr_name = std::format("{}_{}.exr", capture_name_, num_captured_frames_);
-        ++num_captured_frames_;
-        film_.SaveTo(exr_name.c_str());
-    }
-
-    if (changed) {
-        ResetAccumelation();
-    }
-}
-
-void PathTracer::ResetAccumelation() {
-    curr_spp_ = 0;
-}
-
-void PathTracer::BuildAccel() {
-    uint32_t num_instances = scene_.Count<MeshComponent>();
-    uint32_t num_accel_nodes = num_instances * 2 - 1;
-
-    std::vector<kernel::Bbox> accel_leaf_bboxes;
-    accel_leaf_bboxes.reserve(num_instances);
-    std::vector<kernel::AccelTop::Instance> accel_instances;
-    accel_instances.reserve(num_instances);
-    scene_.ForEach<MeshComponent, const MaterialComponent>(
-        [&accel_leaf_bboxes, &accel_instances](SceneObject &object, MeshComponent &mesh, const MaterialComponent &) {
-            mesh.GetMesh()->BuildAccel();
-
-            auto bbox = mesh.GetMesh()->Bbox();
-            auto trans = object.GetTransform();
-            bbox = bbox.TransformBy(trans);
-            accel_leaf_bboxes.push_back(kernel::Bbox {
-                .pmin = glm::vec4(bbox.pmin, 1.0f),
-                .pmax = glm::vec4(bbox.pmax, 1.0f),
-            });
-            accel_instances.push_back(kernel::AccelTop::Instance {
-                .accel = mesh.GetMesh()->AccelBuffer()->TypedGpuData<kernel::AccelBottom>(),
-                .transform = trans,
-                .transform_inv = glm::inverse(trans),
-            });
-        }
-    );
-    num_instances = accel_instances.size();
-    num_accel_nodes = num_instances * 2 - 1;
-
-    std::vector<kernel::Bbox> accel_bboxes(num_accel_nodes);
-    std::copy(accel_leaf_bboxes.begin(), accel_leaf_bboxes.end(), accel_bboxes.begin() + num_instances - 1);
-
-    kernel::Bbox merged_bbox {
-        .pmin = glm::vec4(glm::vec3(std::numeric_limits<float>::max()), 1.0f),
-        .pmax = glm::vec4(glm::vec3(std::numeric_limits<float>::lowest()), 1.0f),
-    };
-    for (size_t i = 0; i < num_instances; i++) {
-        merged_bbox.pmin = glm::min(merged_bbox.pmin, accel_bboxes[num_instances - 1 + i].pmin);
-        merged_bbox.pmax = glm::max(merged_bbox.pmax, accel_bboxes[num_instances - 1 + i].pmax);
-    }
-    
-    auto bbox_buffer_size = sizeof(kernel::Bbox) * num_accel_nodes;
-    if (!accel_bboxes_buffer_ || accel_bboxes_buffer_->Size() < bbox_buffer_size) {
-        accel_bboxes_buffer_ = std::make_unique<CuBuffer>(bbox_buffer_size, accel_bboxes.data());
-    } else {
-        accel_bboxes_buffer_->SetData(accel_bboxes.data(), bbox_buffer_size);
-    }
-    auto instance_buffer_size = sizeof(kernel::AccelTop::Instance) * num_accel_nodes;
-    if (!accel_instances_buffer_ || accel_instances_buffer_->Size() < instance_buffer_size) {
-        accel_instances_buffer_ = std::make_unique<CuBuffer>(instance_buffer_size, accel_instances.data());
-    } else {
-        accel_instances_buffer_->SetData(accel_instances.data(), instance_buffer_size);
-    }
-
-    auto node_buffer_size = sizeof(kernel::AccelNode) * num_accel_nodes;
-    if (!accel_nodes_buffer_ || accel_nodes_buffer_->Size() < node_buffer_size) {
-        accel_nodes_buffer_ = std::make_unique<CuBuffer>(node_buffer_size);
-    }
-
-    kernel::BuildAccel(
-        accel_nodes_buffer_->TypedGpuData<kernel::AccelNode>(),
-        accel_bboxes_buffer_->TypedGpuData<kernel::Bbox>(),
-        merged_bbox, num_instances
-    );
-
-    kernel::AccelTop accel {
-        .nodes = accel_nodes_buffer_->TypedGpuData<kernel::AccelNode>(),
-        .bboxes = accel_bboxes_buffer_->TypedGpuData<kernel::Bbox>(),
-        .instances = accel_instances_buffer_->TypedGpuData<kernel::AccelTop::Instance>(),
-    };
-    if (!accel_buffer_) {
-        accel_buffer_ = std::make_unique<CuBuffer>(sizeof(accel), &accel);
-    } else {
-        accel_buffer_->SetData(&accel, sizeof(accel));
-    }
-}
-
-void PathTracer::BuildInstancesAndLights() {
-    std::vector<kernel::Instance> instances;
-    std::vector<kernel::Light> lights;
-    geo_light_buffers_.clear();
-
-    scene_.ForEach<const MeshComponent, const MaterialComponent>(
-        [this, &instances, &lights](SceneObject &object, const MeshComponent &mesh, const MaterialComponent &material) {
-            kernel::Instance inst {
-                .geometry = {
-                    .type = kernel::Geometry::Type::eTriMesh,
-                    .ptr = mesh.GetMesh()->GeometryBuffer()->GpuData(),
-                },
-                .material = std::bit_cast<kernel::Material>(material.GetMaterial()->Pointer()),
-                .light = {
-                    .type = kernel::Light::Type::eGeometry,
-                    .ptr = nullptr,
-                },
-            };
-
-            if (material.GetMaterial()->IsEmissive()) {
-                auto trans = object.GetTransform();
-
-                kernel::GeometryLight geo_light {
-                    .geometry = inst.geometry,
-                    .material = inst.material,
-                    .transform = trans,
-                    .transform_it = glm::transpose(glm::inverse(trans)),
-                };
-                auto geo_light_buffer = std::make_unique<CuBuffer>(sizeof(geo_light), &geo_light);
-                inst.light.ptr = geo_light_buffer->GpuData();
-                lights.push_back(inst.light);
-                geo_light_buffers_.emplace_back(std::move(geo_light_buffer));
-            }
-
-            instances.push_back(inst);
-        }
-    );
-
-    num_lights_ = lights.size();
-
-    auto instance_buffer_size = sizeof(kernel::Instance) * instances.size();
-    if (!instances_buffer_ || instances_buffer_->Size() < instance_buffer_size) {
-        instances_buffer_ = std::make_unique<CuBuffer>(instance_buffer_size, instances.data());
-    } else {
-        instances_buffer_->SetData(instances.data(), instance_buffer_size);
-    }
-
-    auto light_buffer_size = sizeof(kernel::Light) * lights.size();
-    if (!lights_buffer_ || lights_buffer_->Size() < light_buffer_size) {
-        lights_buffer_ = std::make_unique<CuBuffer>(light_buffer_size, lights.data());
-    } else {
-        lights_buffer_->SetData(lights.data(), light_buffer_size);
-    }
-}
+#include "pathtracer.hpp"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <unordered_set>
+
+#include <imgui.h>
+#include <nlohmann/json.hpp>
+
+#include "scene/camera.hpp"
+#include "kernels/accel/accel_build.cuh"
+#include "kernels/integrator/path.cuh"
+
+namespace {
+
+// cell size of the first level of detail of a mesh relative to the diagonal of its bbox
+constexpr float kLodCellScale = 1.0f / 256.0f;
+
+// uploads the elements of `data` at `indices`, given in increasing order, with one copy for each run of them
+template <typename T>
+void UploadElements(CuBuffer &buffer, const T *data, const std::vector<uint32_t> &indices) {
+    for (size_t i = 0; i < indices.size();) {
+        auto j = i + 1;
+        while (j < indices.size() && indices[j] == indices[j - 1] + 1) {
+            ++j;
+        }
+        buffer.SetData(data + indices[i], sizeof(T) * (indices[j - 1] - indices[i] + 1), sizeof(T) * indices[i]);
+        i = j;
+    }
+}
+
+// whether the linear part of a transform maps axes to axes, in which case world space bbox of a transformed bbox
+// is as tight as the bbox itself
+bool IsAxisAligned(const glm::mat3 &linear) {
+    for (int i = 0; i < 3; i++) {
+        int num_nonzeros = (linear[i].x != 0.0f) + (linear[i].y != 0.0f) + (linear[i].z != 0.0f);
+        if (num_nonzeros > 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// how much a transform scales lengths in object space, taken as the longest of its transformed axes
+float MaxScale(const glm::mat4 &transform) {
+    return std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])),
+        glm::length(glm::vec3(transform[2])) });
+}
+
+nlohmann::json AccelAnalysisToJson(const kernel::AccelAnalysis &analysis, const kernel::AccelBuildStats &stats) {
+    return nlohmann::json {
+        { "leaves", stats.num_leaves },
+        { "references", stats.num_references },
+        { "sah_cost", analysis.sah_cost },
+        { "max_depth", analysis.max_depth },
+        { "average_depth", analysis.average_depth },
+        { "sibling_overlap", analysis.sibling_overlap },
+        { "leaf_size_histogram", analysis.leaf_size_histogram },
+        { "deep_leaves", analysis.num_deep_leaves },
+        { "memory_bytes", analysis.memory_size },
+    };
+}
+
+}
+
+PathTracer::PathTracer(Scene &scene, Film &film) : scene_(scene), film_(film) {}
+
+void PathTracer::BuildBuffers() {
+    CompileObjects();
+    // instances share meshes, whose BVHs are built once
+    std::unordered_set<Mesh *> unique_meshes;
+    std::vector<Mesh *> meshes;
+    for (auto &compiled : compiled_objects_) {
+        if (unique_meshes.insert(compiled.mesh).second) {
+            meshes.push_back(compiled.mesh);
+        }
+    }
+    Mesh::BuildAccels(meshes, &accel_scratch_);
+
+    // a geometry light samples the full mesh and merged meshes shade by per triangle materials of it,
+    // so neither of them uses coarser levels of detail
+    std::vector<const Mesh *> lod_meshes;
+    for (auto &compiled : compiled_objects_) {
+        auto merged = compiled.material_ids_buffer != nullptr;
+        if (lod_levels_ == 0 || merged || compiled.materials[0]->IsEmissive()) {
+            continue;
+        }
+        if (lod_chains_.try_emplace(compiled.mesh).second) {
+            lod_meshes.push_back(compiled.mesh);
+        }
+        compiled.lods = &lod_chains_.at(compiled.mesh);
+    }
+    BuildLods(lod_meshes);
+    BuildAccel();
+
+    scene_.ForEach<CameraComponent>([this](CameraComponent &camera) {
+        camera.BuildBuffer();
+        camera_buffer_ = camera.Buffer();
+        camera_ = &camera;
+    });
+
+    BuildInstancesAndLights();
+    occluders_valid_ = false;
+}
+
+void PathTracer::Update() {
+    if (!camera_buffer_ || num_lights_ == 0) {
+        return;
+    }
+
+    RefitBuffers();
+
+    if (film_.Width() != last_width_ || film_.Height() != last_height_) {
+        ResetAccumelation();
+        last_width_ = film_.Width();
+        last_height_ = film_.Height();
+    }
+
+    auto occluder_buffer_size = sizeof(kernel::AccelOccluder) * film_.Width() * film_.Height();
+    if (!occluders_buffer_ || occluders_buffer_->Size() < occluder_buffer_size) {
+        occluders_buffer_ = std::make_unique<CuBuffer>(occluder_buffer_size);
+        occluders_valid_ = false;
+    }
+    if (!occluders_valid_) {
+        // all bits set is `kernel::kAccelInvalidOccluder`
+        occluders_buffer_->Fill(0xff);
+        occluders_valid_ = true;
+    }
+
+    // a pixel covers about this angle at the center of the film
+    auto lod_spread = lod_levels_ > 0 && camera_ != nullptr ?
+        std::tan(glm::radians(camera_->fov * 0.5f)) * 2.0f / film_.Height() : 0.0f;
+
+    ++curr_spp_;
+    kernel::PathTracer::Params params {
+        .scene = {
+            .camera = {
+                .type = kernel::Camera::Type::ePinhole,
+                .ptr = camera_buffer_->GpuData(),
+            },
+            .light_sampler = {
+                .lights = lights_buffer_->TypedGpuData<kernel::Light>(),
+                .num_lights = num_lights_,
+                .pdf = num_lights_ != 0 ? 1.0f / num_lights_ : 0.0f,
+            },
+            .instances = instances_buffer_->TypedGpuData<kernel::Instance>(),
+            .accel = accel_buffer_->TypedGpuData<kernel::AccelTop>(),
+        },
+        .output = film_.CudaMap(),
+        .occluders = occluders_buffer_->TypedGpuData<kernel::AccelOccluder>(),
+        .lod_spread = lod_spread,
+        .screen_width = film_.Width(),
+        .screen_height = film_.Height(),
+        .spp = curr_spp_,
+        .max_depth = static_cast<uint32_t>(max_depth_),
+        .channel = static_cast<kernel::PathTracer::Params::Channel>(display_channel_),
+    };
+    kernel::PathTracer::Render(params);
+    film_.CudaUnmap();
+}
+
+void PathTracer::ShowUi() {
+    bool changed = false;
+    changed |= ImGui::DragInt("max depth", &max_depth_, 1, -1, 16);
+    ImGui::Text("accumelated spp: %u", curr_spp_);
+    changed |= ImGui::Button("reset accumeltaion");
+
+    const char *channel_name[] = {
+        "Color",
+        "Normal",
+    };
+    changed |= ImGui::Combo("channel", &display_channel_, channel_name,
+        sizeof(channel_name) / sizeof(channel_name[0]));
+
+    if (ImGui::Button("capture frame")) {
+        auto exr_name = std::format("{}_{}.exr", capture_name_, num_captured_frames_);
+        ++num_captured_frames_;
+        film_.SaveTo(exr_name.c_str());
+    }
+
+    if (changed) {
+        ResetAccumelation();
+    }
+}
+
+void PathTracer::ResetAccumelation() {
+    curr_spp_ = 0;
+}
+
+void PathTracer::RefitBuffers() {
+    // merged objects are baked into one mesh with a shared transform, which no longer holds once one of them
+    // moves apart from the others, so objects are merged again
+    for (const auto &compiled : compiled_objects_) {
+        auto trans = compiled.object->GetTransform();
+        for (auto object : compiled.merged_objects) {
+            if (object->GetTransform() != trans) {
+                BuildBuffers();
+                ResetAccumelation();
+                return;
+            }
+        }
+    }
+
+    std::unordered_set<Mesh *> refitted_meshes;
+    for (auto &compiled : compiled_objects_) {
+        if (compiled.mesh->AccelDirty() && refitted_meshes.insert(compiled.mesh).second) {
+            compiled.mesh->RefitAccel(&accel_scratch_);
+        }
+    }
+    std::vector<const Mesh *> lod_meshes;
+    for (auto mesh : refitted_meshes) {
+        if (lod_chains_.contains(mesh)) {
+            lod_meshes.push_back(mesh);
+        }
+    }
+    BuildLods(lod_meshes);
+
+    std::vector<uint32_t> dirty_objects;
+    for (uint32_t i = 0; i < compiled_objects_.size(); i++) {
+        auto &compiled = compiled_objects_[i];
+        auto trans = compiled.object->GetTransform();
+        if (trans != compiled.transform || refitted_meshes.contains(compiled.mesh)) {
+            compiled.transform = trans;
+            dirty_objects.push_back(i);
+        }
+    }
+    if (dirty_objects.empty()) {
+        return;
+    }
+
+    RefitAccel(dirty_objects);
+    UpdateInstancesAndLights(dirty_objects);
+    occluders_valid_ = false;
+    ResetAccumelation();
+}
+
+std::vector<const Mesh *> PathTracer::RenderedMeshes() const {
+    std::vector<const Mesh *> meshes;
+    std::unordered_set<const Mesh *> visited_meshes;
+    for (const auto &compiled : compiled_objects_) {
+        if (visited_meshes.insert(compiled.mesh).second) {
+            meshes.push_back(compiled.mesh);
+        }
+    }
+    return meshes;
+}
+
+void PathTracer::CompileObjects() {
+    compiled_objects_.clear();
+    merged_meshes_.clear();
+    lod_chains_.clear();
+
+    std::unordered_map<const Mesh *, uint32_t> mesh_users;
+    scene_.ForEach<const MeshComponent, const MaterialComponent>(
+        [&mesh_users](const MeshComponent &mesh, const MaterialComponent &) {
+            ++mesh_users[mesh.GetMesh()];
+        }
+    );
+
+    // a geometry light samples all triangles of its mesh, so emissive objects are never merged
+    struct MergeGroup {
+        glm::mat4 transform;
+        std::vector<SceneObject *> objects;
+    };
+    std::vector<MergeGroup> merge_groups;
+    scene_.ForEach<const MeshComponent, const MaterialComponent>(
+        [this, &mesh_users, &merge_groups](SceneObject &object, const MeshComponent &mesh,
+            const MaterialComponent &material) {
+            // nothing can hit an empty mesh, which has no BVH either
+            if (mesh.GetMesh()->IndicesCount() == 0) {
+                return;
+            }
+            auto mergeable = merge_max_triangles_ > 0 && mesh.GetMesh()->IndicesCount() / 3 <= merge_max_triangles_
+                && mesh_users.at(mesh.GetMesh()) == 1 && !material.GetMaterial()->IsEmissive();
+            if (!mergeable) {
+                compiled_objects_.push_back(CompiledObject {
+                    .name = object.Name(),
+                    .object = &object,
+                    .mesh = mesh.GetMesh(),
+                    .materials = { material.GetMaterial() },
+                });
+                return;
+            }
+
+            auto trans = object.GetTransform();
+            auto it = std::find_if(merge_groups.begin(), merge_groups.end(),
+                [&trans](const MergeGroup &group) { return group.transform == trans; });
+            if (it == merge_groups.end()) {
+                it = merge_groups.insert(merge_groups.end(), MergeGroup { .transform = trans });
+            }
+            it->objects.push_back(&object);
+        }
+    );
+
+    for (const auto &group : merge_groups) {
+        if (group.objects.size() == 1) {
+            auto object = group.objects[0];
+            compiled_objects_.push_back(CompiledObject {
+                .name = object->Name(),
+                .object = object,
+                .mesh = object->GetComponent<MeshComponent>()->GetMesh(),
+                .materials = { object->GetComponent<MaterialComponent>()->GetMaterial() },
+            });
+        } else {
+            compiled_objects_.push_back(MergeObjects(group.objects));
+        }
+    }
+
+    for (auto &compiled : compiled_objects_) {
+        compiled.transform = compiled.object->GetTransform();
+    }
+}
+
+PathTracer::CompiledObject PathTracer::MergeObjects(const std::vector<SceneObject *> &objects) {
+    bool has_normals = true;
+    bool has_texcoords = true;
+    for (auto object : objects) {
+        auto mesh = object->GetComponent<MeshComponent>()->GetMesh();
+        has_normals &= mesh->Normals().size() == mesh->VericesCount();
+        has_texcoords &= mesh->Texcoords().size() == mesh->VericesCount();
+    }
+
+    CompiledObject merged {
+        .name = std::format("{} (merged with {} others)", objects[0]->Name(), objects.size() - 1),
+        .object = objects[0],
+        .merged_objects = objects,
+    };
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texcoords;
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> material_ids;
+    for (auto object : objects) {
+        auto mesh = object->GetComponent<MeshComponent>()->GetMesh();
+        auto material = object->GetComponent<MaterialComponent>()->GetMaterial();
+        auto material_it = std::find(merged.materials.begin(), merged.materials.end(), material);
+        if (material_it == merged.materials.end()) {
+            material_it = merged.materials.insert(merged.materials.end(), material);
+        }
+        uint32_t material_id = material_it - merged.materials.begin();
+
+        uint32_t base_index = positions.size();
+        positions.insert(positions.end(), mesh->Positions().begin(), mesh->Positions().end());
+        if (has_normals) {
+            normals.insert(normals.end(), mesh->Normals().begin(), mesh->Normals().end());
+        }
+        if (has_texcoords) {
+            texcoords.insert(texcoords.end(), mesh->Texcoords().begin(), mesh->Texcoords().end());
+        }
+        for (auto index : mesh->Indices()) {
+            indices.push_back(base_index + index);
+        }
+        material_ids.insert(material_ids.end(), mesh->IndicesCount() / 3, material_id);
+    }
+
+    auto first_mesh = objects[0]->GetComponent<MeshComponent>()->GetMesh();
+    auto mesh = std::make_unique<Mesh>();
+    mesh->SetPositions(std::move(positions));
+    mesh->SetIndices(std::move(indices));
+    if (has_normals) {
+        mesh->SetNormals(std::move(normals));
+    } else {
+        mesh->CalcNormals();
+    }
+    if (has_texcoords) {
+        mesh->SetTexcoords(std::move(texcoords));
+    } else {
+        mesh->CalcTexcoords();
+    }
+    mesh->SetAccelOptions(first_mesh->AccelOptions());
+    mesh->SetAccelCacheDir(first_mesh->AccelCacheDir());
+    mesh->SetCompressVertices(first_mesh->CompressesVertices());
+    merged.mesh = mesh.get();
+    merged_meshes_.push_back(std::move(mesh));
+
+    std::vector<kernel::Material> materials;
+    for (auto material : merged.materials) {
+        materials.push_back(std::bit_cast<kernel::Material>(material->Pointer()));
+    }
+    merged.materials_buffer = std::make_unique<CuBuffer>(sizeof(kernel::Material) * materials.size(),
+        materials.data());
+    merged.material_ids_buffer = std::make_unique<CuBuffer>(sizeof(uint32_t) * material_ids.size(),
+        material_ids.data());
+    return merged;
+}
+
+void PathTracer::BuildLods(const std::vector<const Mesh *> &meshes) {
+    std::vector<Mesh *> lod_meshes;
+    for (auto mesh : meshes) {
+        auto &chain = lod_chains_.at(mesh);
+        chain.meshes.clear();
+        chain.cell_size = mesh->Bbox().Extent() * kLodCellScale;
+        auto num_triangles = mesh->IndicesCount() / 3;
+        auto cell_size = chain.cell_size;
+        for (uint32_t level = 0; level < lod_levels_; level++) {
+            auto lod = mesh->Simplify(cell_size);
+            // later levels would be no coarser
+            if (!lod || lod->IndicesCount() / 3 >= num_triangles) {
+                break;
+            }
+            num_triangles = lod->IndicesCount() / 3;
+            lod_meshes.push_back(lod.get());
+            chain.meshes.push_back(std::move(lod));
+            cell_size *= 2.0f;
+        }
+    }
+    Mesh::BuildAccels(lod_meshes, &accel_scratch_);
+
+    for (auto mesh : meshes) {
+        auto &chain = lod_chains_.at(mesh);
+        chain.accels_buffer.reset();
+        if (chain.meshes.empty()) {
+            continue;
+        }
+        std::vector<kernel::AccelBottom *> accels;
+        for (const auto &lod : chain.meshes) {
+            accels.push_back(lod->AccelBuffer()->TypedGpuData<kernel::AccelBottom>());
+        }
+        chain.accels_buffer = std::make_unique<CuBuffer>(sizeof(kernel::AccelBottom *) * accels.size(),
+            accels.data());
+    }
+}
+
+kernel::AccelBottom **PathTracer::LodAccels(const CompiledObject &compiled) {
+    if (compiled.lods == nullptr || !compiled.lods->accels_buffer) {
+        return nullptr;
+    }
+    return compiled.lods->accels_buffer->TypedGpuData<kernel::AccelBottom *>();
+}
+
+kernel::AccelTop::Instance PathTracer::MakeAccelInstance(const CompiledObject &compiled,
+    kernel::Bbox &leaf_bbox) const {
+    const auto &local_bbox = compiled.mesh->AccelBbox();
+    auto bbox = local_bbox.TransformBy(compiled.transform);
+    leaf_bbox = kernel::Bbox {
+        .pmin = glm::vec4(bbox.pmin, 1.0f),
+        .pmax = glm::vec4(bbox.pmax, 1.0f),
+    };
+    return kernel::AccelTop::Instance {
+        .accel = compiled.mesh->AccelBuffer()->TypedGpuData<kernel::AccelBottom>(),
+        .transform_inv = glm::mat4x3(glm::inverse(compiled.transform)),
+        .local_pmin = local_bbox.pmin,
+        .local_pmax = local_bbox.pmax,
+        .rotated = !IsAxisAligned(glm::mat3(compiled.transform)),
+        .lods = LodAccels(compiled),
+        .num_lods = compiled.lods != nullptr ? static_cast<uint32_t>(compiled.lods->meshes.size()) : 0,
+        .lod_error = compiled.lods != nullptr ? compiled.lods->cell_size * MaxScale(compiled.transform) : 0.0f,
+    };
+}
+
+void PathTracer::BuildAccel() {
+    uint32_t num_instances = compiled_objects_.size();
+    uint32_t num_accel_nodes = num_instances * 2 - 1;
+    accel_leaf_bboxes_.resize(num_instances);
+    std::vector<kernel::AccelTop::Instance> accel_instances(num_instances);
+    for (uint32_t i = 0; i < num_instances; i++) {
+        accel_instances[i] = MakeAccelInstance(compiled_objects_[i], accel_leaf_bboxes_[i]);
+    }
+
+    std::vector<kernel::Bbox> accel_bboxes(num_accel_nodes);
+    std::copy(accel_leaf_bboxes_.begin(), accel_leaf_bboxes_.end(), accel_bboxes.begin() + num_instances - 1);
+
+    kernel::Bbox merged_bbox {
+        .pmin = glm::vec4(glm::vec3(std::numeric_limits<float>::max()), 1.0f),
+        .pmax = glm::vec4(glm::vec3(std::numeric_limits<float>::lowest()), 1.0f),
+    };
+    for (size_t i = 0; i < num_instances; i++) {
+        merged_bbox.pmin = glm::min(merged_bbox.pmin, accel_bboxes[num_instances - 1 + i].pmin);
+        merged_bbox.pmax = glm::max(merged_bbox.pmax, accel_bboxes[num_instances - 1 + i].pmax);
+    }
+    
+    auto bbox_buffer_size = sizeof(kernel::Bbox) * num_accel_nodes;
+    if (!accel_bboxes_buffer_ || accel_bboxes_buffer_->Size() < bbox_buffer_size) {
+        accel_bboxes_buffer_ = std::make_unique<CuBuffer>(bbox_buffer_size, accel_bboxes.data());
+    } else {
+        accel_bboxes_buffer_->SetData(accel_bboxes.data(), bbox_buffer_size);
+    }
+    auto instance_buffer_size = sizeof(kernel::AccelTop::Instance) * num_instances;
+    if (!accel_instances_buffer_ || accel_instances_buffer_->Size() < instance_buffer_size) {
+        accel_instances_buffer_ = std::make_unique<CuBuffer>(instance_buffer_size, accel_instances.data());
+    } else {
+        accel_instances_buffer_->SetData(accel_instances.data(), instance_buffer_size);
+    }
+    // kept for refits, which update only the bboxes of changed instances
+    auto leaf_bbox_buffer_size = sizeof(kernel::Bbox) * num_instances;
+    if (!accel_primitive_bboxes_buffer_ || accel_primitive_bboxes_buffer_->Size() < leaf_bbox_buffer_size) {
+        accel_primitive_bboxes_buffer_ = std::make_unique<CuBuffer>(leaf_bbox_buffer_size, accel_leaf_bboxes_.data());
+    } else {
+        accel_primitive_bboxes_buffer_->SetData(accel_leaf_bboxes_.data(), leaf_bbox_buffer_size);
+    }
+
+    auto node_buffer_size = sizeof(kernel::AccelNode) * num_accel_nodes;
+    if (!accel_nodes_buffer_ || accel_nodes_buffer_->Size() < node_buffer_size) {
+        accel_nodes_buffer_ = std::make_unique<CuBuffer>(node_buffer_size);
+    }
+
+    auto packed_node_buffer_size = kernel::AccelPackedNodesSize(top_accel_options_.layout, num_instances);
+    if (packed_node_buffer_size > 0 &&
+        (!accel_packed_nodes_buffer_ || accel_packed_nodes_buffer_->Size() < packed_node_buffer_size)) {
+        accel_packed_nodes_buffer_ = std::make_unique<CuBuffer>(packed_node_buffer_size);
+    }
+    auto packed_nodes = packed_node_buffer_size > 0 ? accel_packed_nodes_buffer_->GpuData() : nullptr;
+
+    auto primitive_id_buffer_size = top_accel_options_.max_leaf_size > 1 ? sizeof(uint32_t) * num_instances : 0;
+    if (primitive_id_buffer_size > 0 &&
+        (!accel_primitive_ids_buffer_ || accel_primitive_ids_buffer_->Size() < primitive_id_buffer_size)) {
+        accel_primitive_ids_buffer_ = std::make_unique<CuBuffer>(primitive_id_buffer_size);
+    }
+    auto primitive_ids =
+        primitive_id_buffer_size > 0 ? accel_primitive_ids_buffer_->TypedGpuData<uint32_t>() : nullptr;
+
+    accel_scratch_.Reserve(kernel::AccelScratchSize(top_accel_options_, num_instances));
+    top_accel_stats_ = kernel::BuildAccel(
+        accel_nodes_buffer_->TypedGpuData<kernel::AccelNode>(),
+        accel_bboxes_buffer_->TypedGpuData<kernel::Bbox>(),
+        merged_bbox, num_instances, top_accel_options_, packed_nodes, primitive_ids, &accel_scratch_
+    );
+    accel_num_instances_ = num_instances;
+    BuildAccelBuffer();
+}
+
+void PathTracer::BuildAccelBuffer() {
+    kernel::AccelTop accel {
+        .layout = top_accel_stats_.layout,
+        .nodes = accel_nodes_buffer_->TypedGpuData<kernel::AccelNode>(),
+        .bboxes = accel_bboxes_buffer_->TypedGpuData<kernel::Bbox>(),
+        .primitive_ids = top_accel_options_.max_leaf_size > 1 ?
+            accel_primitive_ids_buffer_->TypedGpuData<uint32_t>() : nullptr,
+        .packed_nodes = top_accel_options_.layout != kernel::AccelLayout::eBinary ?
+            accel_packed_nodes_buffer_->GpuData() : nullptr,
+        .instances = accel_instances_buffer_->TypedGpuData<kernel::AccelTop::Instance>(),
+        .num_instances = accel_num_instances_,
+    };
+    if (!accel_buffer_) {
+        accel_buffer_ = std::make_unique<CuBuffer>(sizeof(accel), &accel);
+    } else {
+        accel_buffer_->SetData(&accel, sizeof(accel));
+    }
+}
+
+kernel::AccelAnalysis PathTracer::AnalyzeTopAccel() const {
+    uint32_t num_accel_nodes = top_accel_stats_.num_leaves * 2 - 1;
+    std::vector<kernel::AccelNode> nodes(num_accel_nodes);
+    accel_nodes_buffer_->GetData(nodes.data(), sizeof(kernel::AccelNode) * nodes.size());
+    std::vector<kernel::Bbox> bboxes(num_accel_nodes);
+    accel_bboxes_buffer_->GetData(bboxes.data(), sizeof(kernel::Bbox) * bboxes.size());
+    auto num_primitive_ids = top_accel_options_.max_leaf_size > 1 ? top_accel_stats_.num_references : 0;
+    return kernel::AnalyzeAccelHost(nodes.data(), bboxes.data(), top_accel_stats_.num_leaves, num_primitive_ids,
+        top_accel_stats_.layout);
+}
+
+bool PathTracer::WriteAccelReport(const std::filesystem::path &path) {
+    auto meshes_json = nlohmann::json::array();
+    std::unordered_set<const Mesh *> reported_meshes;
+    for (const auto &compiled : compiled_objects_) {
+        if (!reported_meshes.insert(compiled.mesh).second) {
+            continue;
+        }
+        auto mesh_json = AccelAnalysisToJson(compiled.mesh->AnalyzeAccel(), compiled.mesh->AccelStats());
+        mesh_json["name"] = compiled.name;
+        mesh_json["triangles"] = compiled.mesh->IndicesCount() / 3;
+        meshes_json.push_back(std::move(mesh_json));
+    }
+    auto instances_json = AccelAnalysisToJson(AnalyzeTopAccel(), top_accel_stats_);
+    instances_json["instances"] = accel_num_instances_;
+
+    std::ofstream fout(path);
+    fout << nlohmann::json { { "meshes", meshes_json }, { "instances", instances_json } }.dump(2) << std::endl;
+    return static_cast<bool>(fout);
+}
+
+void PathTracer::RefitAccel(const std::vector<uint32_t> &dirty_objects) {
+    uint32_t num_instances = compiled_objects_.size();
+    if (!accel_buffer_ || num_instances != accel_num_instances_) {
+        BuildAccel();
+        return;
+    }
+
+    std::vector<kernel::AccelTop::Instance> accel_instances(num_instances);
+    for (auto index : dirty_objects) {
+        accel_instances[index] = MakeAccelInstance(compiled_objects_[index], accel_leaf_bboxes_[index]);
+    }
+    UploadElements(*accel_primitive_bboxes_buffer_, accel_leaf_bboxes_.data(), dirty_objects);
+    UploadElements(*accel_instances_buffer_, accel_instances.data(), dirty_objects);
+
+    auto parent_buffer_size = sizeof(uint32_t) * (num_instances * 2 - 1);
+    if (!accel_parents_buffer_ || accel_parents_buffer_->Size() < parent_buffer_size) {
+        accel_parents_buffer_ = std::make_unique<CuBuffer>(parent_buffer_size);
+    }
+
+    auto primitive_ids = top_accel_options_.max_leaf_size > 1 ?
+        accel_primitive_ids_buffer_->TypedGpuData<uint32_t>() : nullptr;
+    auto packed_nodes = top_accel_options_.layout != kernel::AccelLayout::eBinary ?
+        accel_packed_nodes_buffer_->GpuData() : nullptr;
+    accel_scratch_.Reserve(kernel::AccelRefitScratchSize(top_accel_stats_.num_leaves, top_accel_options_.layout));
+    // packed again with the requested layout, which a wide tree may fall back from or return to
+    auto refit_stats = kernel::RefitAccel(
+        accel_nodes_buffer_->TypedGpuData<kernel::AccelNode>(),
+        accel_bboxes_buffer_->TypedGpuData<kernel::Bbox>(),
+        accel_parents_buffer_->TypedGpuData<uint32_t>(),
+        accel_primitive_bboxes_buffer_->TypedGpuData<kernel::Bbox>(),
+        primitive_ids, top_accel_stats_.num_leaves, top_accel_options_.layout, packed_nodes, &accel_scratch_
+    );
+    if (refit_stats.sah_cost > top_accel_options_.max_refit_cost_ratio * top_accel_stats_.sah_cost) {
+        BuildAccel();
+    } else if (refit_stats.layout != top_accel_stats_.layout) {
+        top_accel_stats_.layout = refit_stats.layout;
+        BuildAccelBuffer();
+    }
+}
+
+kernel::Instance PathTracer::MakeInstance(const CompiledObject &compiled) const {
+    auto material = compiled.materials[0];
+    auto merged = compiled.material_ids_buffer != nullptr;
+    return kernel::Instance {
+        .geometry = {
+            .type = kernel::Geometry::Type::eTriMesh,
+            .ptr = compiled.mesh->GeometryBuffer()->GpuData(),
+        },
+        .material = std::bit_cast<kernel::Material>(material->Pointer()),
+        .light = {
+            .type = kernel::Light::Type::eGeometry,
+            .ptr = compiled.light_buffer != nullptr ? compiled.light_buffer->GpuData() : nullptr,
+        },
+        .transform = glm::mat4x3(compiled.transform),
+        .normal_matrix = glm::transpose(glm::inverse(glm::mat3(compiled.transform))),
+        .materials = merged ? compiled.materials_buffer->TypedGpuData<kernel::Material>() : nullptr,
+        .material_ids = merged ? compiled.material_ids_buffer->TypedGpuData<uint32_t>() : nullptr,
+        .lods = LodAccels(compiled),
+    };
+}
+
+void PathTracer::BuildInstancesAndLights() {
+    std::vector<kernel::Instance> instances;
+    std::vector<kernel::Light> lights;
+    geo_light_buffers_.clear();
+
+    for (auto &compiled : compiled_objects_) {
+        compiled.light_buffer = nullptr;
+        auto inst = MakeInstance(compiled);
+
+        auto merged = compiled.material_ids_buffer != nullptr;
+        if (!merged && compiled.materials[0]->IsEmissive()) {
+            kernel::GeometryLight geo_light {
+                .geometry = inst.geometry,
+                .material = inst.material,
+                .transform = inst.transform,
+                .normal_matrix = inst.normal_matrix,
+            };
+            auto geo_light_buffer = std::make_unique<CuBuffer>(sizeof(geo_light), &geo_light);
+            compiled.light_buffer = geo_light_buffer.get();
+            inst.light.ptr = geo_light_buffer->GpuData();
+            lights.push_back(inst.light);
+            geo_light_buffers_.emplace_back(std::move(geo_light_buffer));
+        }
+
+        instances.push_back(inst);
+    }
+
+    num_lights_ = lights.size();
+
+    auto instance_buffer_size = sizeof(kernel::Instance) * instances.size();
+    if (!instances_buffer_ || instances_buffer_->Size() < instance_buffer_size) {
+        instances_buffer_ = std::make_unique<CuBuffer>(instance_buffer_size, instances.data());
+    } else {
+        instances_buffer_->SetData(instances.data(), instance_buffer_size);
+    }
+
+    auto light_buffer_size = sizeof(kernel::Light) * lights.size();
+    if (!lights_buffer_ || lights_buffer_->Size() < light_buffer_size) {
+        lights_buffer_ = std::make_unique<CuBuffer>(light_buffer_size, lights.data());
+    } else {
+        lights_buffer_->SetData(lights.data(), light_buffer_size);
+    }
+}
+
+void PathTracer::UpdateInstancesAndLights(const std::vector<uint32_t> &dirty_objects) {
+    std::vector<kernel::Instance> instances(compiled_objects_.size());
+    for (auto index : dirty_objects) {
+        const auto &compiled = compiled_objects_[index];
+        instances[index] = MakeInstance(compiled);
+        if (compiled.light_buffer != nullptr) {
+            kernel::GeometryLight geo_light {
+                .geometry = instances[index].geometry,
+                .material = instances[index].material,
+                .transform = instances[index].transform,
+                .normal_matrix = instances[index].normal_matrix,
+            };
+            compiled.light_buffer->SetData(&geo_light, sizeof(geo_light));
+        }
+    }
+    UploadElements(*instances_buffer_, instances.data(), dirty_objects);
+}
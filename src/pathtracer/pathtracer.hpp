@@ -1,50 +1,137 @@
-#pragma once
-
-#include "film.hpp"
-#include "cuda_helpers/buffer.hpp"
-#include "scene/core.hpp"
-
-class PathTracer {
-public:
-    PathTracer(Scene &scene, Film &film);
-
-    void BuildBuffers();
-
-    void ResetAccumelation();
-
-    void Update();
-
-    void ShowUi();
-
-    void SetCaptureName(std::string_view capture_name) { capture_name_ = capture_name; }
-    void SetMaxDepth(int max_depth) { max_depth_ = max_depth; }
-
-private:
-    void BuildAccel();
-    void BuildInstancesAndLights();
-
-    Scene &scene_;
-    Film &film_;
-
-    uint32_t num_captured_frames_ = 0;
-    std::string capture_name_;
-
-    int max_depth_ = -1;
-    uint32_t curr_spp_ = 0;
-    int display_channel_ = 0;
-
-    uint32_t last_width_ = 0;
-    uint32_t last_height_ = 0;
-
-    std::unique_ptr<CuBuffer> accel_buffer_;
-    std::unique_ptr<CuBuffer> accel_nodes_buffer_;
-    std::unique_ptr<CuBuffer> accel_bboxes_buffer_;
-    std::unique_ptr<CuBuffer> accel_instances_buffer_;
-
-    std::unique_ptr<CuBuffer> instances_buffer_;
-    std::unique_ptr<CuBuffer> lights_buffer_;
-    uint32_t num_lights_ = 0;
-    std::vector<std::unique_ptr<CuBuffer>> geo_light_buffers_;
-
-    CuBuffer *camera_buffer_ = nullptr;
-};
+#pragma once
+
+#include <filesystem>
+#include <unordered_map>
+
+#include "film.hpp"
+#include "cuda_helpers/buffer.hpp"
+#include "scene/camera.hpp"
+#include "scene/core.hpp"
+#include "scene/mesh.hpp"
+#include "scene/material.hpp"
+#include "kernels/accel/accel_build.cuh"
+#include "kernels/scene/instance.cuh"
+
+class PathTracer {
+public:
+    PathTracer(Scene &scene, Film &film);
+
+    void BuildBuffers();
+    // updates buffers after objects are moved or vertices of meshes are changed, only meshes and instances that
+    // changed since the last update are touched, the instance BVH is refitted instead of rebuilt as long as
+    // its quality allows, called by `Update` before each frame and resets accumulation when anything changed
+    void RefitBuffers();
+
+    void ResetAccumelation();
+
+    void Update();
+
+    void ShowUi();
+
+    void SetCaptureName(std::string_view capture_name) { capture_name_ = capture_name; }
+    void SetMaxDepth(int max_depth) { max_depth_ = max_depth; }
+    void SetTopAccelOptions(const kernel::AccelBuildOptions &options) { top_accel_options_ = options; }
+    // objects with meshes of at most this many triangles that are not shared or emissive are merged into one mesh
+    // per distinct transform when buffers are built, 0 to disable, merged objects should not be moved afterwards
+    void SetMergeMaxTriangles(uint32_t max_triangles) { merge_max_triangles_ = max_triangles; }
+    // objects that are not merged or emissive get up to this many coarser levels of detail of their meshes made by
+    // `Mesh::Simplify`, one of which is picked for each ray hitting them by its footprint, 0 to disable
+    void SetLodLevels(uint32_t levels) { lod_levels_ = levels; }
+    // meshes that are rendered, each once, including merged ones instead of those merged into them
+    std::vector<const Mesh *> RenderedMeshes() const;
+    const kernel::AccelBuildStats &TopAccelStats() const { return top_accel_stats_; }
+    kernel::AccelAnalysis AnalyzeTopAccel() const;
+    // writes the analyses of the BVHs of meshes and of the instance BVH as JSON
+    bool WriteAccelReport(const std::filesystem::path &path);
+
+private:
+    struct LodChain {
+        // from the finest, each made with twice the cell size of the last
+        std::vector<std::unique_ptr<Mesh>> meshes;
+        // cell size of the first level in object space
+        float cell_size;
+        // `kernel::AccelBottom *` of each of `meshes`
+        std::unique_ptr<CuBuffer> accels_buffer;
+    };
+
+    struct CompiledObject {
+        std::string name;
+        // transform is taken from it
+        SceneObject *object;
+        Mesh *mesh;
+        // one material, or one for each value of `material_ids_buffer` if objects are merged
+        std::vector<Material *> materials;
+        std::unique_ptr<CuBuffer> materials_buffer;
+        std::unique_ptr<CuBuffer> material_ids_buffer;
+        // all objects baked into `mesh` with the transform of `object` if objects are merged, empty otherwise
+        std::vector<SceneObject *> merged_objects;
+        // transform buffers are last updated with, an object is moved if it differs from that of `object`
+        glm::mat4 transform;
+        // geometry light of emissive objects
+        CuBuffer *light_buffer = nullptr;
+        // coarser levels of detail of `mesh`, null if there are none
+        LodChain *lods = nullptr;
+    };
+
+    void CompileObjects();
+    CompiledObject MergeObjects(const std::vector<SceneObject *> &objects);
+    // makes the LOD chains of `meshes` again from their current vertices, with BVHs built in one batch
+    void BuildLods(const std::vector<const Mesh *> &meshes);
+    // BVHs of the levels of detail of an object in device memory, null if it has none
+    static kernel::AccelBottom **LodAccels(const CompiledObject &compiled);
+    kernel::AccelTop::Instance MakeAccelInstance(const CompiledObject &compiled, kernel::Bbox &leaf_bbox) const;
+    void BuildAccel();
+    // uploads the record of the instance BVH built by `BuildAccel`
+    void BuildAccelBuffer();
+    // `dirty_objects` are the indices of compiled objects that are moved or whose meshes are changed
+    void RefitAccel(const std::vector<uint32_t> &dirty_objects);
+    kernel::Instance MakeInstance(const CompiledObject &compiled) const;
+    void BuildInstancesAndLights();
+    void UpdateInstancesAndLights(const std::vector<uint32_t> &dirty_objects);
+
+    Scene &scene_;
+    Film &film_;
+
+    uint32_t num_captured_frames_ = 0;
+    std::string capture_name_;
+
+    int max_depth_ = -1;
+    uint32_t curr_spp_ = 0;
+    int display_channel_ = 0;
+
+    uint32_t last_width_ = 0;
+    uint32_t last_height_ = 0;
+
+    uint32_t merge_max_triangles_ = 0;
+    std::vector<CompiledObject> compiled_objects_;
+    std::vector<std::unique_ptr<Mesh>> merged_meshes_;
+    uint32_t lod_levels_ = 0;
+    std::unordered_map<const Mesh *, LodChain> lod_chains_;
+
+    kernel::AccelBuildOptions top_accel_options_;
+    kernel::AccelBuildStats top_accel_stats_;
+    uint32_t accel_num_instances_ = 0;
+    std::vector<kernel::Bbox> accel_leaf_bboxes_;
+    std::unique_ptr<CuBuffer> accel_buffer_;
+    std::unique_ptr<CuBuffer> accel_nodes_buffer_;
+    std::unique_ptr<CuBuffer> accel_bboxes_buffer_;
+    std::unique_ptr<CuBuffer> accel_packed_nodes_buffer_;
+    std::unique_ptr<CuBuffer> accel_primitive_ids_buffer_;
+    std::unique_ptr<CuBuffer> accel_primitive_bboxes_buffer_;
+    std::unique_ptr<CuBuffer> accel_parents_buffer_;
+    std::unique_ptr<CuBuffer> accel_instances_buffer_;
+    // temporary buffers of all BVH builds and refits, kept so that rebuilding allocates nothing
+    CuScratch accel_scratch_;
+
+    std::unique_ptr<CuBuffer> instances_buffer_;
+    // one `kernel::AccelOccluder` per pixel, cleared after buffers are updated since cached primitives may be gone
+    std::unique_ptr<CuBuffer> occluders_buffer_;
+    bool occluders_valid_ = false;
+    std::unique_ptr<CuBuffer> lights_buffer_;
+    uint32_t num_lights_ = 0;
+    std::vector<std::unique_ptr<CuBuffer>> geo_light_buffers_;
+
+    CuBuffer *camera_buffer_ = nullptr;
+    // its fov sets the spread of ray cones picking levels of detail
+    CameraComponent *camera_ = nullptr;
+};
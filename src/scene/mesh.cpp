@@ -1,149 +1,616 @@
-#include "mesh.hpp"
-
-#include <numbers>
-
-#include "kernels/accel/accel_build.cuh"
-
-void Mesh::SetPositions(std::vector<glm::vec3> &&positions) {
-    positions_ = std::move(positions);
-    bbox_.Empty();
-    for (const auto &pos : positions_) {
-        bbox_.Merge(pos);
-    }
-
-    auto buffer_size = sizeof(glm::vec3) * positions_.size();
-    if (!positions_buffer_ || positions_buffer_->Size() < buffer_size) {
-        positions_buffer_ = std::make_unique<CuBuffer>(buffer_size, positions_.data());
-    } else {
-        positions_buffer_->SetData(positions_.data(), buffer_size);
-    }
-}
-
-void Mesh::SetNormals(std::vector<glm::vec3> &&normals) {
-    normals_ = std::move(normals);
-
-    auto buffer_size = sizeof(glm::vec3) * normals_.size();
-    if (!normals_buffer_ || normals_buffer_->Size() < buffer_size) {
-        normals_buffer_ = std::make_unique<CuBuffer>(buffer_size, normals_.data());
-    } else {
-        normals_buffer_->SetData(normals_.data(), buffer_size);
-    }
-}
-
-void Mesh::SetTexcoords(std::vector<glm::vec2> &&texcoords) {
-    texcoords_ = std::move(texcoords);
-
-    auto buffer_size = sizeof(glm::vec2) * texcoords_.size();
-    if (!texcoords_buffer_ || texcoords_buffer_->Size() < buffer_size) {
-        texcoords_buffer_ = std::make_unique<CuBuffer>(buffer_size, texcoords_.data());
-    } else {
-        texcoords_buffer_->SetData(texcoords_.data(), buffer_size);
-    }
-}
-
-void Mesh::SetIndices(std::vector<uint32_t> &&indices) {
-    indices_ = std::move(indices);
-
-    auto buffer_size = sizeof(uint32_t) * indices_.size();
-    if (!indices_buffer_ || indices_buffer_->Size() < buffer_size) {
-        indices_buffer_ = std::make_unique<CuBuffer>(buffer_size, indices_.data());
-    } else {
-        indices_buffer_->SetData(indices_.data(), buffer_size);
-    }
-}
-
-void Mesh::CalcNormals() {
-    normals_.resize(positions_.size(), glm::vec3(0.0f));
-    for (size_t i = 0; i < indices_.size(); i += 3) {
-        auto p0 = positions_[indices_[i]];
-        auto p1 = positions_[indices_[i + 1]];
-        auto p2 = positions_[indices_[i + 2]];
-        auto n = glm::normalize(glm::cross(p1 - p0, p2 - p0));
-        normals_[indices_[i]] += n;
-        normals_[indices_[i + 1]] += n;
-        normals_[indices_[i + 2]] += n;
-    }
-    for (auto &norm : normals_) {
-        norm = glm::normalize(norm);
-    }
-}
-
-void Mesh::CalcTexcoords() {
-    texcoords_.resize(positions_.size());
-    for (size_t i = 0; i < positions_.size(); i++) {
-        auto vec = glm::normalize(positions_[i] - bbox_.Centroid());
-        auto theta = std::acos(vec.y);
-        auto phi = std::atan2(vec.z, vec.x);
-        if (phi < 0.0f) {
-            phi += 2.0f * std::numbers::pi;
-        }
-        texcoords_[i] = glm::vec2(phi * std::numbers::inv_pi * 0.5f, 1.0f - theta * std::numbers::inv_pi);
-    }
-}
-
-void Mesh::BuildAccel() {
-    uint32_t num_triangles = indices_.size() / 3;
-    uint32_t num_accel_nodes = num_triangles * 2 - 1;
-
-    std::vector<kernel::Bbox> accel_bboxes(num_accel_nodes);
-    for (size_t i = 0; i < num_triangles; i++) {
-        auto i0 = indices_[3 * i];
-        auto i1 = indices_[3 * i + 1];
-        auto i2 = indices_[3 * i + 2];
-        auto p0 = positions_[i0];
-        auto p1 = positions_[i1];
-        auto p2 = positions_[i2];
-        accel_bboxes[num_triangles - 1 + i].pmin = glm::vec4(glm::min(p0, glm::min(p1, p2)), 1.0f);
-        accel_bboxes[num_triangles - 1 + i].pmax = glm::vec4(glm::max(p0, glm::max(p1, p2)), 1.0f);
-    }
-    auto bbox_buffer_size = sizeof(kernel::Bbox) * num_accel_nodes;
-    if (!accel_bboxes_buffer_ || accel_bboxes_buffer_->Size() < bbox_buffer_size) {
-        accel_bboxes_buffer_ = std::make_unique<CuBuffer>(bbox_buffer_size, accel_bboxes.data());
-    } else {
-        accel_bboxes_buffer_->SetData(accel_bboxes.data(), bbox_buffer_size);
-    }
-
-    auto node_buffer_size = sizeof(kernel::AccelNode) * num_accel_nodes;
-    if (!accel_nodes_buffer_ || accel_nodes_buffer_->Size() < node_buffer_size) {
-        accel_nodes_buffer_ = std::make_unique<CuBuffer>(node_buffer_size);
-    }
-
-    kernel::Bbox merged_bbox {
-        .pmin = glm::vec4(bbox_.pmin, 1.0f),
-        .pmax = glm::vec4(bbox_.pmax, 1.0f),
-    };
-
-    kernel::BuildAccel(
-        accel_nodes_buffer_->TypedGpuData<kernel::AccelNode>(),
-        accel_bboxes_buffer_->TypedGpuData<kernel::Bbox>(),
-        merged_bbox, num_triangles
-    );
-
-
-    kernel::TriMesh trimesh {
-        .positions = positions_buffer_->TypedGpuData<glm::vec3>(),
-        .normals = normals_buffer_->TypedGpuData<glm::vec3>(),
-        .texcoords = texcoords_buffer_->TypedGpuData<glm::vec2>(),
-        .indices = indices_buffer_->TypedGpuData<uint32_t>(),
-        .num_triangles = num_triangles,
-    };
-    if (!geometry_buffer_) {
-        geometry_buffer_ = std::make_unique<CuBuffer>(sizeof(trimesh), &trimesh);
-    } else {
-        geometry_buffer_->SetData(&trimesh, sizeof(trimesh));
-    }
-
-    kernel::AccelBottom accel {
-        .nodes = accel_nodes_buffer_->TypedGpuData<kernel::AccelNode>(),
-        .bboxes = accel_bboxes_buffer_->TypedGpuData<kernel::Bbox>(),
-        .geometry = {
-            .type = kernel::Geometry::Type::eTriMesh,
-            .ptr = geometry_buffer_->GpuData(),
-        }
-    };
-    if (!accel_buffer_) {
-        accel_buffer_ = std::make_unique<CuBuffer>(sizeof(accel), &accel);
-    } else {
-        accel_buffer_->SetData(&accel, sizeof(accel));
-    }
-}
+#include "mesh.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <numbers>
+#include <unordered_map>
+
+#include "kernels/accel/accel_build.cuh"
+
+namespace {
+
+constexpr uint32_t kAccelCacheMagic = 0x43485642; // "BVHC"
+constexpr uint32_t kAccelCacheVersion = 4;
+
+// followed by the build stats, nodes, bboxes, primitive ids and packed nodes
+struct AccelCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t num_primitives;
+    uint32_t builder;
+    uint32_t num_sah_bins;
+    uint32_t ploc_radius;
+    uint32_t layout;
+    uint32_t num_treelet_passes;
+    uint32_t max_leaf_size;
+    float max_spatial_split_growth;
+};
+
+AccelCacheHeader MakeAccelCacheHeader(uint64_t key, uint32_t num_primitives,
+    const kernel::AccelBuildOptions &options) {
+    return AccelCacheHeader {
+        .magic = kAccelCacheMagic,
+        .version = kAccelCacheVersion,
+        .key = key,
+        .num_primitives = num_primitives,
+        .builder = static_cast<uint32_t>(options.builder),
+        .num_sah_bins = options.num_sah_bins,
+        .ploc_radius = options.ploc_radius,
+        .layout = static_cast<uint32_t>(options.layout),
+        .num_treelet_passes = options.num_treelet_passes,
+        .max_leaf_size = options.max_leaf_size,
+        .max_spatial_split_growth = options.max_spatial_split_growth,
+    };
+}
+
+// FNV-1a
+uint64_t HashBytes(uint64_t hash, const void *data, size_t size) {
+    auto bytes = reinterpret_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+template <typename T>
+bool ReadVector(std::ifstream &fin, std::vector<T> &data) {
+    return static_cast<bool>(fin.read(reinterpret_cast<char *>(data.data()), sizeof(T) * data.size()));
+}
+
+template <typename T>
+void WriteVector(std::ofstream &fout, const std::vector<T> &data) {
+    fout.write(reinterpret_cast<const char *>(data.data()), sizeof(T) * data.size());
+}
+
+}
+
+void Mesh::SetPositions(std::vector<glm::vec3> &&positions) {
+    positions_ = std::move(positions);
+    bbox_.Empty();
+    for (const auto &pos : positions_) {
+        bbox_.Merge(pos);
+    }
+
+    auto buffer_size = sizeof(glm::vec3) * positions_.size();
+    if (!positions_buffer_ || positions_buffer_->Size() < buffer_size) {
+        positions_buffer_ = std::make_unique<CuBuffer>(buffer_size, positions_.data());
+    } else {
+        positions_buffer_->SetData(positions_.data(), buffer_size);
+    }
+    accel_dirty_ = true;
+}
+
+void Mesh::SetNormals(std::vector<glm::vec3> &&normals) {
+    normals_ = std::move(normals);
+
+    auto buffer_size = sizeof(glm::vec3) * normals_.size();
+    if (!normals_buffer_ || normals_buffer_->Size() < buffer_size) {
+        normals_buffer_ = std::make_unique<CuBuffer>(buffer_size, normals_.data());
+    } else {
+        normals_buffer_->SetData(normals_.data(), buffer_size);
+    }
+    accel_dirty_ = true;
+}
+
+void Mesh::SetTexcoords(std::vector<glm::vec2> &&texcoords) {
+    texcoords_ = std::move(texcoords);
+
+    auto buffer_size = sizeof(glm::vec2) * texcoords_.size();
+    if (!texcoords_buffer_ || texcoords_buffer_->Size() < buffer_size) {
+        texcoords_buffer_ = std::make_unique<CuBuffer>(buffer_size, texcoords_.data());
+    } else {
+        texcoords_buffer_->SetData(texcoords_.data(), buffer_size);
+    }
+    accel_dirty_ = true;
+}
+
+void Mesh::SetIndices(std::vector<uint32_t> &&indices) {
+    indices_ = std::move(indices);
+
+    auto buffer_size = sizeof(uint32_t) * indices_.size();
+    if (!indices_buffer_ || indices_buffer_->Size() < buffer_size) {
+        indices_buffer_ = std::make_unique<CuBuffer>(buffer_size, indices_.data());
+    } else {
+        indices_buffer_->SetData(indices_.data(), buffer_size);
+    }
+    accel_dirty_ = true;
+}
+
+void Mesh::CalcNormals() {
+    normals_.resize(positions_.size(), glm::vec3(0.0f));
+    for (size_t i = 0; i < indices_.size(); i += 3) {
+        auto p0 = positions_[indices_[i]];
+        auto p1 = positions_[indices_[i + 1]];
+        auto p2 = positions_[indices_[i + 2]];
+        auto n = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+        normals_[indices_[i]] += n;
+        normals_[indices_[i + 1]] += n;
+        normals_[indices_[i + 2]] += n;
+    }
+    for (auto &norm : normals_) {
+        norm = glm::normalize(norm);
+    }
+}
+
+void Mesh::CalcTexcoords() {
+    texcoords_.resize(positions_.size());
+    for (size_t i = 0; i < positions_.size(); i++) {
+        auto vec = glm::normalize(positions_[i] - bbox_.Centroid());
+        auto theta = std::acos(vec.y);
+        auto phi = std::atan2(vec.z, vec.x);
+        if (phi < 0.0f) {
+            phi += 2.0f * std::numbers::pi;
+        }
+        texcoords_[i] = glm::vec2(phi * std::numbers::inv_pi * 0.5f, 1.0f - theta * std::numbers::inv_pi);
+    }
+}
+
+std::unique_ptr<Mesh> Mesh::Simplify(float cell_size) const {
+    auto has_normals = normals_.size() == positions_.size();
+    auto has_texcoords = texcoords_.size() == positions_.size();
+
+    std::unordered_map<uint64_t, uint32_t> cell_vertices;
+    std::vector<uint32_t> vertex_remap(positions_.size());
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texcoords;
+    std::vector<uint32_t> num_merged;
+    for (size_t i = 0; i < positions_.size(); i++) {
+        // 21 bits for each axis
+        auto cell = glm::min(glm::uvec3((positions_[i] - bbox_.pmin) / cell_size), glm::uvec3((1u << 21) - 1));
+        auto key = (static_cast<uint64_t>(cell.x) << 42) | (static_cast<uint64_t>(cell.y) << 21) | cell.z;
+        auto [it, inserted] = cell_vertices.try_emplace(key, static_cast<uint32_t>(positions.size()));
+        if (inserted) {
+            positions.push_back(glm::vec3(0.0f));
+            normals.push_back(glm::vec3(0.0f));
+            texcoords.push_back(glm::vec2(0.0f));
+            num_merged.push_back(0);
+        }
+        auto vertex = it->second;
+        vertex_remap[i] = vertex;
+        positions[vertex] += positions_[i];
+        if (has_normals) {
+            normals[vertex] += normals_[i];
+        }
+        if (has_texcoords) {
+            texcoords[vertex] += texcoords_[i];
+        }
+        ++num_merged[vertex];
+    }
+    for (size_t i = 0; i < positions.size(); i++) {
+        positions[i] /= static_cast<float>(num_merged[i]);
+        texcoords[i] /= static_cast<float>(num_merged[i]);
+        // normals of opposite sides may cancel out
+        normals[i] = glm::length(normals[i]) > 0.0f ? glm::normalize(normals[i]) : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+
+    std::vector<uint32_t> indices;
+    for (size_t i = 0; i < indices_.size(); i += 3) {
+        auto v0 = vertex_remap[indices_[i]];
+        auto v1 = vertex_remap[indices_[i + 1]];
+        auto v2 = vertex_remap[indices_[i + 2]];
+        if (v0 != v1 && v1 != v2 && v2 != v0) {
+            indices.insert(indices.end(), { v0, v1, v2 });
+        }
+    }
+    if (indices.empty()) {
+        return nullptr;
+    }
+
+    auto mesh = std::make_unique<Mesh>();
+    mesh->SetPositions(std::move(positions));
+    mesh->SetIndices(std::move(indices));
+    if (has_normals) {
+        mesh->SetNormals(std::move(normals));
+    } else {
+        mesh->CalcNormals();
+    }
+    if (has_texcoords) {
+        mesh->SetTexcoords(std::move(texcoords));
+    } else {
+        mesh->CalcTexcoords();
+    }
+    mesh->SetAccelOptions(accel_options_);
+    mesh->SetAccelCacheDir(accel_cache_dir_);
+    mesh->SetCompressVertices(compress_vertices_);
+    return mesh;
+}
+
+std::vector<kernel::Bbox> Mesh::CalcTriangleBboxes() const {
+    const auto &positions = AccelPositions();
+    uint32_t num_triangles = indices_.size() / 3;
+    std::vector<kernel::Bbox> triangle_bboxes(num_triangles);
+    for (size_t i = 0; i < num_triangles; i++) {
+        auto i0 = indices_[3 * i];
+        auto i1 = indices_[3 * i + 1];
+        auto i2 = indices_[3 * i + 2];
+        auto p0 = positions[i0];
+        auto p1 = positions[i1];
+        auto p2 = positions[i2];
+        triangle_bboxes[i].pmin = glm::vec4(glm::min(p0, glm::min(p1, p2)), 1.0f);
+        triangle_bboxes[i].pmax = glm::vec4(glm::max(p0, glm::max(p1, p2)), 1.0f);
+    }
+    return triangle_bboxes;
+}
+
+void Mesh::CompressVertices() {
+    // the step is a power of 2 so that decoding is exact, see `kernel::DecodePosition`
+    auto extent = bbox_.pmax - bbox_.pmin;
+    for (int i = 0; i < 3; i++) {
+        position_scale_[i] = extent[i] > 0.0f ? std::exp2(std::ceil(std::log2(extent[i] / 65535.0f))) : 1.0f;
+    }
+    position_offset_ = bbox_.pmin;
+
+    std::vector<kernel::TriMeshCompressedVertex> vertices(positions_.size());
+    quantized_positions_.resize(positions_.size());
+    quantized_bbox_.Empty();
+    for (size_t i = 0; i < positions_.size(); i++) {
+        auto position = glm::clamp(glm::round((positions_[i] - position_offset_) / position_scale_), 0.0f, 65535.0f);
+        vertices[i] = kernel::TriMeshCompressedVertex {
+            .position = glm::u16vec3(position),
+            .padding = 0,
+            .normal = glm::packSnorm2x16(kernel::EncodeOctahedral(normals_[i])),
+            .texcoord = glm::packHalf2x16(texcoords_[i]),
+        };
+        quantized_positions_[i] = kernel::DecodePosition(vertices[i].position, position_offset_, position_scale_);
+        quantized_bbox_.Merge(quantized_positions_[i]);
+    }
+
+    auto buffer_size = sizeof(kernel::TriMeshCompressedVertex) * vertices.size();
+    if (!compressed_vertices_buffer_ || compressed_vertices_buffer_->Size() < buffer_size) {
+        compressed_vertices_buffer_ = std::make_unique<CuBuffer>(buffer_size, vertices.data());
+    } else {
+        compressed_vertices_buffer_->SetData(vertices.data(), buffer_size);
+    }
+    positions_buffer_.reset();
+    normals_buffer_.reset();
+    texcoords_buffer_.reset();
+}
+
+void Mesh::BuildGeometryBuffer() {
+    uint32_t num_triangles = indices_.size() / 3;
+    kernel::TriMesh trimesh {
+        .indices = indices_buffer_->TypedGpuData<uint32_t>(),
+        .num_triangles = num_triangles,
+    };
+    if (compress_vertices_) {
+        // triangles are decoded from the vertices when intersected, storing them would take most of the memory
+        trimesh.compressed_vertices = compressed_vertices_buffer_->TypedGpuData<kernel::TriMeshCompressedVertex>();
+        trimesh.position_offset = position_offset_;
+        trimesh.position_scale = position_scale_;
+        trimesh.primitive_ids = accel_primitive_ids_buffer_->TypedGpuData<uint32_t>();
+        triangles_buffer_.reset();
+    } else {
+        trimesh.positions = positions_buffer_->TypedGpuData<glm::vec3>();
+        trimesh.normals = normals_buffer_->TypedGpuData<glm::vec3>();
+        trimesh.texcoords = texcoords_buffer_->TypedGpuData<glm::vec2>();
+
+        // a triangle is stored once for each leaf referencing it
+        auto num_references = accel_stats_.num_references;
+        auto triangle_buffer_size = sizeof(kernel::TriMeshTriangle) * num_references;
+        if (!triangles_buffer_ || triangles_buffer_->Size() < triangle_buffer_size) {
+            triangles_buffer_ = std::make_unique<CuBuffer>(triangle_buffer_size);
+        }
+        trimesh.triangles = triangles_buffer_->TypedGpuData<kernel::TriMeshTriangle>();
+        kernel::TriMesh::BuildTriangles(trimesh.triangles, trimesh,
+            accel_primitive_ids_buffer_->TypedGpuData<uint32_t>(), num_references);
+    }
+    if (!geometry_buffer_) {
+        geometry_buffer_ = std::make_unique<CuBuffer>(sizeof(trimesh), &trimesh);
+    } else {
+        geometry_buffer_->SetData(&trimesh, sizeof(trimesh));
+    }
+}
+
+void Mesh::BuildAccel(CuScratch *scratch) {
+    BuildAccels({ this }, scratch);
+}
+
+void Mesh::BuildAccels(const std::vector<Mesh *> &meshes, CuScratch *scratch) {
+    struct PendingBuild {
+        Mesh *mesh;
+        std::filesystem::path cache_path;
+        uint64_t cache_key;
+    };
+    std::vector<PendingBuild> pending_builds;
+    std::vector<kernel::AccelBatchItem> batch_items;
+    std::vector<Mesh *> batch_meshes;
+    std::vector<Mesh *> spatial_meshes;
+    for (auto mesh : meshes) {
+        // an empty mesh has neither a BVH nor triangles to build, and would size its buffers from -1 nodes
+        if (mesh->indices_.empty()) {
+            continue;
+        }
+        mesh->PrepareAccelBuffers();
+
+        auto cache_key = mesh->accel_cache_dir_.empty() ? 0 : mesh->AccelCacheKey();
+        auto cache_path = mesh->accel_cache_dir_.empty() ?
+            std::filesystem::path {} : mesh->accel_cache_dir_ / std::format("{:016x}.bvh", cache_key);
+        if (!cache_path.empty() && mesh->LoadAccelCache(cache_path, cache_key)) {
+            continue;
+        }
+        pending_builds.push_back(PendingBuild { mesh, cache_path, cache_key });
+
+        // spatial splits are searched on the CPU for each mesh, others are built in one batch
+        if (mesh->accel_options_.builder == kernel::AccelBuilder::eSbvh) {
+            spatial_meshes.push_back(mesh);
+        } else {
+            batch_items.push_back(mesh->MakeAccelBatchItem());
+            batch_meshes.push_back(mesh);
+        }
+    }
+
+    // the scratch memory is grown once for the largest build, so that building the same meshes again
+    // allocates nothing
+    if (scratch) {
+        auto scratch_size = kernel::AccelBatchScratchSize(batch_items.data(), batch_items.size());
+        for (auto mesh : spatial_meshes) {
+            scratch_size = std::max(scratch_size,
+                kernel::AccelScratchSize(mesh->accel_options_, mesh->indices_.size() / 3));
+        }
+        scratch->Reserve(scratch_size);
+    }
+
+    for (auto mesh : spatial_meshes) {
+        uint32_t num_triangles = mesh->indices_.size() / 3;
+        auto packed_nodes = mesh->accel_options_.layout != kernel::AccelLayout::eBinary ?
+            mesh->accel_packed_nodes_buffer_->GpuData() : nullptr;
+        mesh->accel_stats_ = kernel::BuildAccelSpatial(
+            mesh->accel_nodes_buffer_->TypedGpuData<kernel::AccelNode>(),
+            mesh->accel_bboxes_buffer_->TypedGpuData<kernel::Bbox>(),
+            mesh->AccelPositions().data(), mesh->indices_.data(), num_triangles, mesh->accel_options_,
+            packed_nodes, mesh->accel_primitive_ids_buffer_->TypedGpuData<uint32_t>(), scratch);
+    }
+
+    std::vector<kernel::AccelBuildStats> batch_stats(batch_items.size());
+    kernel::BuildAccelBatched(batch_items.data(), batch_items.size(), batch_stats.data(), scratch);
+    for (size_t i = 0; i < batch_meshes.size(); i++) {
+        batch_meshes[i]->accel_stats_ = batch_stats[i];
+    }
+    for (const auto &pending : pending_builds) {
+        if (!pending.cache_path.empty()) {
+            pending.mesh->SaveAccelCache(pending.cache_path, pending.cache_key);
+        }
+    }
+
+    for (auto mesh : meshes) {
+        mesh->accel_num_triangles_ = mesh->indices_.size() / 3;
+        if (mesh->indices_.empty()) {
+            mesh->accel_stats_ = {};
+            mesh->accel_buffer_.reset();
+        } else {
+            mesh->BuildGeometryBuffer();
+            mesh->BuildAccelBuffer();
+        }
+        mesh->accel_dirty_ = false;
+    }
+}
+
+void Mesh::PrepareAccelBuffers() {
+    if (compress_vertices_) {
+        CompressVertices();
+    }
+
+    uint32_t num_triangles = indices_.size() / 3;
+    // spatial splits may reference a triangle from more than one leaf
+    auto max_references = kernel::AccelMaxReferences(accel_options_, num_triangles);
+    uint32_t num_accel_nodes = max_references * 2 - 1;
+
+    auto bbox_buffer_size = sizeof(kernel::Bbox) * num_accel_nodes;
+    if (!accel_bboxes_buffer_ || accel_bboxes_buffer_->Size() < bbox_buffer_size) {
+        accel_bboxes_buffer_ = std::make_unique<CuBuffer>(bbox_buffer_size);
+    }
+
+    auto node_buffer_size = sizeof(kernel::AccelNode) * num_accel_nodes;
+    if (!accel_nodes_buffer_ || accel_nodes_buffer_->Size() < node_buffer_size) {
+        accel_nodes_buffer_ = std::make_unique<CuBuffer>(node_buffer_size);
+    }
+
+    auto packed_node_buffer_size = kernel::AccelPackedNodesSize(accel_options_.layout, max_references);
+    if (packed_node_buffer_size > 0 &&
+        (!accel_packed_nodes_buffer_ || accel_packed_nodes_buffer_->Size() < packed_node_buffer_size)) {
+        accel_packed_nodes_buffer_ = std::make_unique<CuBuffer>(packed_node_buffer_size);
+    }
+
+    // triangles are stored in the order of BVH leaves, so primitive ids are always needed
+    auto primitive_id_buffer_size = sizeof(uint32_t) * max_references;
+    if (!accel_primitive_ids_buffer_ || accel_primitive_ids_buffer_->Size() < primitive_id_buffer_size) {
+        accel_primitive_ids_buffer_ = std::make_unique<CuBuffer>(primitive_id_buffer_size);
+    }
+}
+
+kernel::AccelBatchItem Mesh::MakeAccelBatchItem() const {
+    kernel::AccelBatchItem item {
+        .mesh = {
+            .indices = indices_buffer_->TypedGpuData<uint32_t>(),
+            .num_triangles = static_cast<uint32_t>(indices_.size() / 3),
+        },
+        .nodes = accel_nodes_buffer_->TypedGpuData<kernel::AccelNode>(),
+        .bboxes = accel_bboxes_buffer_->TypedGpuData<kernel::Bbox>(),
+        .packed_nodes = accel_options_.layout != kernel::AccelLayout::eBinary ?
+            accel_packed_nodes_buffer_->GpuData() : nullptr,
+        .primitive_ids = accel_primitive_ids_buffer_->TypedGpuData<uint32_t>(),
+        .merged_bbox = {
+            .pmin = glm::vec4(AccelBbox().pmin, 1.0f),
+            .pmax = glm::vec4(AccelBbox().pmax, 1.0f),
+        },
+        .options = accel_options_,
+    };
+    if (compress_vertices_) {
+        item.mesh.compressed_vertices = compressed_vertices_buffer_->TypedGpuData<kernel::TriMeshCompressedVertex>();
+        item.mesh.position_offset = position_offset_;
+        item.mesh.position_scale = position_scale_;
+    } else {
+        item.mesh.positions = positions_buffer_->TypedGpuData<glm::vec3>();
+    }
+    return item;
+}
+
+void Mesh::BuildAccelBuffer() {
+    kernel::AccelBottom accel {
+        .layout = accel_stats_.layout,
+        .nodes = accel_nodes_buffer_->TypedGpuData<kernel::AccelNode>(),
+        .bboxes = accel_bboxes_buffer_->TypedGpuData<kernel::Bbox>(),
+        .packed_nodes = accel_options_.layout != kernel::AccelLayout::eBinary ?
+            accel_packed_nodes_buffer_->GpuData() : nullptr,
+        .geometry = {
+            .type = kernel::Geometry::Type::eTriMesh,
+            .ptr = geometry_buffer_->GpuData(),
+        }
+    };
+    if (!accel_buffer_) {
+        accel_buffer_ = std::make_unique<CuBuffer>(sizeof(accel), &accel);
+    } else {
+        accel_buffer_->SetData(&accel, sizeof(accel));
+    }
+}
+
+void Mesh::RefitAccel(CuScratch *scratch) {
+    uint32_t num_triangles = indices_.size() / 3;
+    if (!accel_buffer_ || num_triangles != accel_num_triangles_) {
+        BuildAccel(scratch);
+        return;
+    }
+
+    if (compress_vertices_) {
+        CompressVertices();
+    }
+    auto triangle_bboxes = CalcTriangleBboxes();
+    auto bbox_buffer_size = sizeof(kernel::Bbox) * num_triangles;
+    if (!accel_primitive_bboxes_buffer_ || accel_primitive_bboxes_buffer_->Size() < bbox_buffer_size) {
+        accel_primitive_bboxes_buffer_ = std::make_unique<CuBuffer>(bbox_buffer_size, triangle_bboxes.data());
+    } else {
+        accel_primitive_bboxes_buffer_->SetData(triangle_bboxes.data(), bbox_buffer_size);
+    }
+
+    auto parent_buffer_size = sizeof(uint32_t) * (accel_stats_.num_leaves * 2 - 1);
+    if (!accel_parents_buffer_ || accel_parents_buffer_->Size() < parent_buffer_size) {
+        accel_parents_buffer_ = std::make_unique<CuBuffer>(parent_buffer_size);
+    }
+
+    auto packed_nodes = accel_options_.layout != kernel::AccelLayout::eBinary ?
+        accel_packed_nodes_buffer_->GpuData() : nullptr;
+    if (scratch) {
+        scratch->Reserve(kernel::AccelRefitScratchSize(accel_stats_.num_leaves, accel_options_.layout));
+    }
+    // packed again with the requested layout, which a wide tree may fall back from or return to
+    auto refit_stats = kernel::RefitAccel(
+        accel_nodes_buffer_->TypedGpuData<kernel::AccelNode>(),
+        accel_bboxes_buffer_->TypedGpuData<kernel::Bbox>(),
+        accel_parents_buffer_->TypedGpuData<uint32_t>(),
+        accel_primitive_bboxes_buffer_->TypedGpuData<kernel::Bbox>(),
+        accel_primitive_ids_buffer_->TypedGpuData<uint32_t>(),
+        accel_stats_.num_leaves, accel_options_.layout, packed_nodes, scratch
+    );
+    if (refit_stats.sah_cost > accel_options_.max_refit_cost_ratio * accel_stats_.sah_cost) {
+        BuildAccel(scratch);
+        return;
+    }
+    auto layout_changed = refit_stats.layout != accel_stats_.layout;
+    accel_stats_.layout = refit_stats.layout;
+
+    // triangles are rebuilt from new positions, which may also have been moved to a larger buffer
+    BuildGeometryBuffer();
+    if (layout_changed) {
+        BuildAccelBuffer();
+    }
+    accel_dirty_ = false;
+}
+
+kernel::AccelAnalysis Mesh::AnalyzeAccel() const {
+    if (accel_stats_.num_leaves == 0) {
+        return {};
+    }
+    uint32_t num_accel_nodes = accel_stats_.num_leaves * 2 - 1;
+    std::vector<kernel::AccelNode> nodes(num_accel_nodes);
+    accel_nodes_buffer_->GetData(nodes.data(), sizeof(kernel::AccelNode) * nodes.size());
+    std::vector<kernel::Bbox> bboxes(num_accel_nodes);
+    accel_bboxes_buffer_->GetData(bboxes.data(), sizeof(kernel::Bbox) * bboxes.size());
+    return kernel::AnalyzeAccelHost(nodes.data(), bboxes.data(), accel_stats_.num_leaves,
+        accel_stats_.num_references, accel_stats_.layout);
+}
+
+uint64_t Mesh::AccelCacheKey() const {
+    const auto &positions = AccelPositions();
+    auto hash = HashBytes(0xcbf29ce484222325ull, positions.data(), sizeof(glm::vec3) * positions.size());
+    return HashBytes(hash, indices_.data(), sizeof(uint32_t) * indices_.size());
+}
+
+bool Mesh::LoadAccelCache(const std::filesystem::path &path, uint64_t key) {
+    std::ifstream fin(path, std::ios::binary);
+    if (!fin) {
+        return false;
+    }
+
+    uint32_t num_triangles = indices_.size() / 3;
+    auto expected_header = MakeAccelCacheHeader(key, num_triangles, accel_options_);
+    AccelCacheHeader header;
+    kernel::AccelBuildStats stats;
+    if (!fin.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(&header, &expected_header, sizeof(header)) != 0 ||
+        !fin.read(reinterpret_cast<char *>(&stats), sizeof(stats)) ||
+        stats.num_leaves == 0 || stats.num_leaves > stats.num_references ||
+        stats.num_references > kernel::AccelMaxReferences(accel_options_, num_triangles)) {
+        return false;
+    }
+
+    uint32_t num_accel_nodes = stats.num_leaves * 2 - 1;
+    std::vector<kernel::AccelNode> nodes(num_accel_nodes);
+    std::vector<kernel::Bbox> bboxes(num_accel_nodes);
+    std::vector<uint32_t> primitive_ids(stats.num_references);
+    std::vector<uint8_t> packed_nodes(kernel::AccelPackedNodesSize(accel_options_.layout, stats.num_leaves));
+    if (!ReadVector(fin, nodes) || !ReadVector(fin, bboxes) || !ReadVector(fin, primitive_ids) ||
+        !ReadVector(fin, packed_nodes)) {
+        return false;
+    }
+
+    accel_nodes_buffer_->SetData(nodes.data(), sizeof(kernel::AccelNode) * nodes.size());
+    accel_bboxes_buffer_->SetData(bboxes.data(), sizeof(kernel::Bbox) * bboxes.size());
+    accel_primitive_ids_buffer_->SetData(primitive_ids.data(), sizeof(uint32_t) * primitive_ids.size());
+    if (!packed_nodes.empty()) {
+        accel_packed_nodes_buffer_->SetData(packed_nodes.data(), packed_nodes.size());
+    }
+    accel_stats_ = stats;
+    return true;
+}
+
+void Mesh::SaveAccelCache(const std::filesystem::path &path, uint64_t key) const {
+    uint32_t num_triangles = indices_.size() / 3;
+    uint32_t num_accel_nodes = accel_stats_.num_leaves * 2 - 1;
+    std::vector<kernel::AccelNode> nodes(num_accel_nodes);
+    accel_nodes_buffer_->GetData(nodes.data(), sizeof(kernel::AccelNode) * nodes.size());
+    std::vector<kernel::Bbox> bboxes(num_accel_nodes);
+    accel_bboxes_buffer_->GetData(bboxes.data(), sizeof(kernel::Bbox) * bboxes.size());
+    std::vector<uint32_t> primitive_ids(accel_stats_.num_references);
+    accel_primitive_ids_buffer_->GetData(primitive_ids.data(), sizeof(uint32_t) * primitive_ids.size());
+    std::vector<uint8_t> packed_nodes(kernel::AccelPackedNodesSize(accel_options_.layout, accel_stats_.num_leaves));
+    if (!packed_nodes.empty()) {
+        accel_packed_nodes_buffer_->GetData(packed_nodes.data(), packed_nodes.size());
+    }
+
+    // written aside and renamed so that a partially written file is never loaded
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    auto temp_path = path;
+    temp_path += ".tmp";
+    {
+        std::ofstream fout(temp_path, std::ios::binary);
+        auto header = MakeAccelCacheHeader(key, num_triangles, accel_options_);
+        fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        fout.write(reinterpret_cast<const char *>(&accel_stats_), sizeof(accel_stats_));
+        WriteVector(fout, nodes);
+        WriteVector(fout, bboxes);
+        WriteVector(fout, primitive_ids);
+        WriteVector(fout, packed_nodes);
+        if (!fout) {
+            std::cout << "failed to write BVH cache '" << path << "'" << std::endl;
+            return;
+        }
+    }
+    std::filesystem::rename(temp_path, path, ec);
+}
@@ -1,64 +1,124 @@
-#pragma once
-
-#include <vector>
-#include <memory>
-
-#include <glm/glm.hpp>
-
-#include "bbox.hpp"
-#include "cuda_helpers/buffer.hpp"
-
-class Mesh {
-public:
-    void SetPositions(std::vector<glm::vec3> &&positions);
-    void SetNormals(std::vector<glm::vec3> &&normals);
-    void SetTexcoords(std::vector<glm::vec2> &&texcoords);
-    void SetIndices(std::vector<uint32_t> &&indices);
-
-    void CalcNormals();
-    void CalcTexcoords();
-
-    size_t VericesCount() const { return positions_.size(); }
-    const std::vector<glm::vec3> &Positions() const { return positions_; }
-    const std::vector<glm::vec3> &Normals() const { return normals_; }
-    const std::vector<glm::vec2> &Texcoords() const { return texcoords_; }
-    size_t IndicesCount() const { return indices_.size(); }
-    const std::vector<uint32_t> &Indices() const { return indices_; }
-
-    const Bbox &Bbox() const { return bbox_; }
-
-    CuBuffer *PositionBuffer() const { return positions_buffer_.get(); }
-    CuBuffer *NormalBuffer() const { return normals_buffer_.get(); }
-    CuBuffer *IndexBuffer() const { return indices_buffer_.get(); }
-
-    CuBuffer *GeometryBuffer() const { return geometry_buffer_.get(); }
-
-    void BuildAccel();
-    CuBuffer *AccelBuffer() const { return accel_buffer_.get(); }
-
-private:
-    std::vector<glm::vec3> positions_;
-    std::vector<glm::vec3> normals_;
-    std::vector<glm::vec2> texcoords_;
-    std::vector<uint32_t> indices_;
-    struct Bbox bbox_;
-
-    std::unique_ptr<CuBuffer> geometry_buffer_;
-    std::unique_ptr<CuBuffer> positions_buffer_;
-    std::unique_ptr<CuBuffer> normals_buffer_;
-    std::unique_ptr<CuBuffer> texcoords_buffer_;
-    std::unique_ptr<CuBuffer> indices_buffer_;
-
-    std::unique_ptr<CuBuffer> accel_buffer_;
-    std::unique_ptr<CuBuffer> accel_nodes_buffer_;
-    std::unique_ptr<CuBuffer> accel_bboxes_buffer_;
-};
-
-class MeshComponent {
-public:
-    void SetMesh(std::shared_ptr<Mesh> mesh) { mesh_ = mesh; }
-    Mesh *GetMesh() const { return mesh_.get(); }
-
-private:
-    std::shared_ptr<Mesh> mesh_;
-};
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <filesystem>
+
+#include <glm/glm.hpp>
+
+#include "bbox.hpp"
+#include "cuda_helpers/buffer.hpp"
+#include "kernels/accel/accel_build.cuh"
+
+class Mesh {
+public:
+    void SetPositions(std::vector<glm::vec3> &&positions);
+    void SetNormals(std::vector<glm::vec3> &&normals);
+    void SetTexcoords(std::vector<glm::vec2> &&texcoords);
+    void SetIndices(std::vector<uint32_t> &&indices);
+
+    void CalcNormals();
+    void CalcTexcoords();
+    // coarser mesh made by vertex clustering, where vertices in each cube of `cell_size` on a grid over the bbox
+    // are merged into their average and triangles left degenerate are dropped, null if no triangle is left
+    std::unique_ptr<Mesh> Simplify(float cell_size) const;
+
+    size_t VericesCount() const { return positions_.size(); }
+    const std::vector<glm::vec3> &Positions() const { return positions_; }
+    const std::vector<glm::vec3> &Normals() const { return normals_; }
+    const std::vector<glm::vec2> &Texcoords() const { return texcoords_; }
+    size_t IndicesCount() const { return indices_.size(); }
+    const std::vector<uint32_t> &Indices() const { return indices_; }
+
+    const Bbox &Bbox() const { return bbox_; }
+    // bbox of the positions BVH is built from, which may differ from `Bbox` if vertices are compressed
+    const struct Bbox &AccelBbox() const { return compress_vertices_ ? quantized_bbox_ : bbox_; }
+
+    CuBuffer *PositionBuffer() const { return positions_buffer_.get(); }
+    CuBuffer *NormalBuffer() const { return normals_buffer_.get(); }
+    CuBuffer *IndexBuffer() const { return indices_buffer_.get(); }
+
+    CuBuffer *GeometryBuffer() const { return geometry_buffer_.get(); }
+
+    void SetAccelOptions(const kernel::AccelBuildOptions &options) { accel_options_ = options; }
+    const kernel::AccelBuildOptions &AccelOptions() const { return accel_options_; }
+    // built BVHs are saved to and loaded from this directory, keyed by a hash of positions and indices
+    void SetAccelCacheDir(const std::filesystem::path &dir) { accel_cache_dir_ = dir; }
+    const std::filesystem::path &AccelCacheDir() const { return accel_cache_dir_; }
+    // vertices are stored in 16 bytes on the device when BVH is built, with positions quantized in the bbox,
+    // octahedral encoded normals and half float texcoords, and triangles are decoded from them when intersected
+    // instead of being stored in BVH leaf order
+    void SetCompressVertices(bool compress) { compress_vertices_ = compress; }
+    bool CompressesVertices() const { return compress_vertices_; }
+
+    // temporary buffers of the build are taken from `scratch` if given, which is grown to fit them before building
+    void BuildAccel(CuScratch *scratch = nullptr);
+    // same as calling `BuildAccel` of each mesh, but BVHs not loaded from the cache are built in one batch
+    static void BuildAccels(const std::vector<Mesh *> &meshes, CuScratch *scratch = nullptr);
+    // updates bboxes of the built BVH after positions are changed, rebuilds it if its quality drops too much
+    void RefitAccel(CuScratch *scratch = nullptr);
+    // whether vertices or indices are set after BVH is last built or refitted
+    bool AccelDirty() const { return accel_dirty_; }
+    // null for an empty mesh, which has no BVH
+    CuBuffer *AccelBuffer() const { return accel_buffer_.get(); }
+    const kernel::AccelBuildStats &AccelStats() const { return accel_stats_; }
+    kernel::AccelAnalysis AnalyzeAccel() const;
+
+private:
+    // positions BVH and triangles are built from, decoded from compressed vertices if they are used
+    const std::vector<glm::vec3> &AccelPositions() const {
+        return compress_vertices_ ? quantized_positions_ : positions_;
+    }
+    std::vector<kernel::Bbox> CalcTriangleBboxes() const;
+    void CompressVertices();
+    void BuildGeometryBuffer();
+    void PrepareAccelBuffers();
+    kernel::AccelBatchItem MakeAccelBatchItem() const;
+    void BuildAccelBuffer();
+    uint64_t AccelCacheKey() const;
+    bool LoadAccelCache(const std::filesystem::path &path, uint64_t key);
+    void SaveAccelCache(const std::filesystem::path &path, uint64_t key) const;
+
+    std::vector<glm::vec3> positions_;
+    std::vector<glm::vec3> normals_;
+    std::vector<glm::vec2> texcoords_;
+    std::vector<uint32_t> indices_;
+    struct Bbox bbox_;
+
+    std::unique_ptr<CuBuffer> geometry_buffer_;
+    std::unique_ptr<CuBuffer> positions_buffer_;
+    std::unique_ptr<CuBuffer> normals_buffer_;
+    std::unique_ptr<CuBuffer> texcoords_buffer_;
+    std::unique_ptr<CuBuffer> indices_buffer_;
+    std::unique_ptr<CuBuffer> triangles_buffer_;
+
+    bool compress_vertices_ = false;
+    std::vector<glm::vec3> quantized_positions_;
+    struct Bbox quantized_bbox_;
+    glm::vec3 position_offset_ = glm::vec3(0.0f);
+    glm::vec3 position_scale_ = glm::vec3(1.0f);
+    std::unique_ptr<CuBuffer> compressed_vertices_buffer_;
+
+    kernel::AccelBuildOptions accel_options_;
+    kernel::AccelBuildStats accel_stats_;
+    uint32_t accel_num_triangles_ = 0;
+    bool accel_dirty_ = true;
+    std::filesystem::path accel_cache_dir_;
+    std::unique_ptr<CuBuffer> accel_buffer_;
+    std::unique_ptr<CuBuffer> accel_nodes_buffer_;
+    std::unique_ptr<CuBuffer> accel_bboxes_buffer_;
+    std::unique_ptr<CuBuffer> accel_packed_nodes_buffer_;
+    std::unique_ptr<CuBuffer> accel_primitive_ids_buffer_;
+    std::unique_ptr<CuBuffer> accel_primitive_bboxes_buffer_;
+    std::unique_ptr<CuBuffer> accel_parents_buffer_;
+};
+
+class MeshComponent {
+public:
+    void SetMesh(std::shared_ptr<Mesh> mesh) { mesh_ = mesh; }
+    Mesh *GetMesh() const { return mesh_.get(); }
+    const std::shared_ptr<Mesh> &GetSharedMesh() const { return mesh_; }
+
+private:
+    std::shared_ptr<Mesh> mesh_;
+};